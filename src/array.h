@@ -17,6 +17,11 @@
  <typedef:<PA>type>, associated therewith; required. `<PA>` is private, whose
  names are prefixed in a manner to avoid collisions.
 
+ @param[ARRAY_REALLOC, ARRAY_FREE]
+ Function-like macros that replace `realloc` and `free`; they are also given
+ the array first, `ARRAY_REALLOC(a, data, size)` and `ARRAY_FREE(a, data)`.
+ Both or neither; the default is the standard library.
+
  @param[ARRAY_EXPECT_TRAIT]
  Do not un-define certain variables for subsequent inclusion in a parameterized
  trait.
@@ -90,6 +95,13 @@
 #ifndef ARRAY_MIN_CAPACITY /* <!-- !min; */
 #define ARRAY_MIN_CAPACITY 3 /* > 1 */
 #endif /* !min --> */
+#if !defined(ARRAY_REALLOC) != !defined(ARRAY_FREE)
+#error ARRAY_REALLOC and ARRAY_FREE go together.
+#endif
+#ifndef ARRAY_REALLOC /* <!-- !alloc */
+#define ARRAY_REALLOC(a, data, size) realloc(data, size)
+#define ARRAY_FREE(a, data) free(data)
+#endif /* !alloc --> */
 
 /** A valid tag type set by `ARRAY_TYPE`. */
 typedef ARRAY_TYPE PA_(type);
@@ -198,7 +210,7 @@ static struct A_(array) A_(array)(void)
 
 /** If `a` is not null, destroys and returns it to idle. @allow */
 static void A_(array_)(struct A_(array) *const a)
-	{ if(a) free(a->data), *a = A_(array)(); }
+	{ if(a) ARRAY_FREE(a, a->data), *a = A_(array)(); }
 
 /** @return An iterator of `a`. */
 static struct A_(array_iterator) A_(array_iterator)(struct A_(array) *a)
@@ -240,7 +252,7 @@ static int A_(array_reserve)(struct A_(array) *const a, const size_t min) {
 		if(c0 >= c1) { c0 = max_size; break; } /* Unlikely. */
 		c0 = c1;
 	}
-	if(!(data = realloc(a->data, sizeof *a->data * c0)))
+	if(!(data = ARRAY_REALLOC(a, a->data, sizeof *a->data * c0)))
 		{ if(!errno) errno = ERANGE; return 0; }
 	a->data = data, a->capacity = c0;
 	return 1;
@@ -299,7 +311,7 @@ static int A_(array_shrink)(struct A_(array) *const a) {
 	assert(a && a->capacity >= a->size);
 	if(!a->data) return assert(!a->size && !a->capacity), 1;
 	c = a->size && a->size > ARRAY_MIN_CAPACITY ? a->size : ARRAY_MIN_CAPACITY;
-	if(!(data = realloc(a->data, sizeof *a->data * c)))
+	if(!(data = ARRAY_REALLOC(a, a->data, sizeof *a->data * c)))
 		{ if(!errno) errno = ERANGE; return 0; }
 	a->data = data, a->capacity = c;
 	return 1;
@@ -462,6 +474,8 @@ static const char *(*PA_(array_to_string))(const struct A_(array) *)
 #endif
 #undef ARRAY_NAME
 #undef ARRAY_TYPE
+#undef ARRAY_REALLOC
+#undef ARRAY_FREE
 #undef BOX_
 #undef BOX
 #undef BOX_CONTENT
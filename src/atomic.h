@@ -0,0 +1,50 @@
+/** @license 2021 Neil Edelman, distributed under the terms of the
+ [MIT License](https://opensource.org/licenses/MIT).
+
+ @abstract Header <src/atomic.h> is used by <src/lockfree.h>,
+ <src/owner.h>, <src/percpu.h>, and the counters of `POOL_STATS` in
+ <src/pool.h>.
+
+ @subtitle Atomics
+
+ The few atomic operations that the concurrent pools use: C11
+ <stdatomic.h> if it is there, otherwise the `__atomic` builtins of GCC and
+ clang, which have the same memory model, so they work in C89. Objects that
+ are accessed with them are declared `POOL_ATOMIC(type)`, and the memory
+ orders are `POOL_RELAXED`, `POOL_ACQUIRE`, `POOL_RELEASE`, and
+ `POOL_ACQ_REL`.
+
+ @std C11 or GNU C89 */
+
+#ifndef ATOMIC_H /* <!-- idempotent */
+#define ATOMIC_H
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L \
+	&& !defined(__STDC_NO_ATOMICS__) /* <!-- c11 */
+#include <stdatomic.h>
+#define POOL_ATOMIC(t) _Atomic(t)
+#define POOL_RELAXED memory_order_relaxed
+#define POOL_ACQUIRE memory_order_acquire
+#define POOL_RELEASE memory_order_release
+#define POOL_ACQ_REL memory_order_acq_rel
+#define POOL_LOAD(a, o) atomic_load_explicit(a, o)
+#define POOL_STORE(a, v, o) atomic_store_explicit(a, v, o)
+#define POOL_EXCHANGE(a, v, o) atomic_exchange_explicit(a, v, o)
+#define POOL_FETCH_ADD(a, v, o) atomic_fetch_add_explicit(a, v, o)
+#define POOL_CAS(a, expect, v, o, fail) \
+	atomic_compare_exchange_weak_explicit(a, expect, v, o, fail)
+#elif defined(__GNUC__) /* c11 --><!-- gnu */
+#define POOL_ATOMIC(t) t
+#define POOL_RELAXED __ATOMIC_RELAXED
+#define POOL_ACQUIRE __ATOMIC_ACQUIRE
+#define POOL_RELEASE __ATOMIC_RELEASE
+#define POOL_ACQ_REL __ATOMIC_ACQ_REL
+#define POOL_LOAD(a, o) __atomic_load_n(a, o)
+#define POOL_STORE(a, v, o) __atomic_store_n(a, v, o)
+#define POOL_EXCHANGE(a, v, o) __atomic_exchange_n(a, v, o)
+#define POOL_FETCH_ADD(a, v, o) __atomic_fetch_add(a, v, o)
+#define POOL_CAS(a, expect, v, o, fail) \
+	__atomic_compare_exchange_n(a, expect, v, 1, o, fail)
+#else /* gnu --><!-- none */
+#error <src/atomic.h> needs C11 atomics or GCC builtins.
+#endif /* none --> */
+#endif /* idempotent --> */
@@ -31,6 +31,10 @@
  Optional value <typedef:<PH>value>, that, on `HEAP_VALUE`, is stored in
  <tag:<H>heapnode>, which is <typedef:<PH>value>.
 
+ @param[HEAP_REALLOC, HEAP_FREE]
+ Passed to the <src/array.h> underneath as `ARRAY_REALLOC` and `ARRAY_FREE`;
+ the array is the first member of the heap. Both or neither.
+
  @param[HEAP_EXPECT_TRAIT]
  Do not un-define certain variables for subsequent inclusion in a parameterized
  trait.
@@ -126,6 +130,13 @@ typedef PH_(priority_c) PH_(node_c);
 /* This relies on <src/array.h> which must be in the same directory. */
 #define ARRAY_NAME PH_(node)
 #define ARRAY_TYPE PH_(node)
+#if !defined(HEAP_REALLOC) != !defined(HEAP_FREE)
+#error HEAP_REALLOC and HEAP_FREE go together.
+#endif
+#ifdef HEAP_REALLOC /* <!-- alloc */
+#define ARRAY_REALLOC HEAP_REALLOC
+#define ARRAY_FREE HEAP_FREE
+#endif /* alloc --> */
 #include "array.h"
 
 /* Box override information. */
@@ -419,6 +430,10 @@ static void PH_(unused_to_string_coda)(void) { PH_(unused_to_string)(); }
 #ifdef HEAP_VALUE
 #undef HEAP_VALUE
 #endif
+#ifdef HEAP_REALLOC
+#undef HEAP_REALLOC
+#undef HEAP_FREE
+#endif
 #undef BOX_
 #undef BOX
 #undef BOX_CONTENT
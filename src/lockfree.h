@@ -0,0 +1,208 @@
+/** @license 2021 Neil Edelman, distributed under the terms of the
+ [MIT License](https://opensource.org/licenses/MIT).
+
+ @abstract Header <src/lockfree.h> depends on <src/pool.h>, instantiated
+ before with the same `POOL_NAME` and `POOL_TYPE`, and atomics; examples
+ <test/test_pool.c>.
+
+ @subtitle Lock-free pool
+
+ <tag:<P>lockfree> is a pool that any number of threads can use at once
+ without a lock. It has a fixed table of `POOL_LOCKFREE_SLABS` slabs, each
+ twice the size of the one before, which are allocated on demand and
+ published with release semantics; nothing moves, so pointers are stable.
+ Items are handed out from a count of used items, advanced with a
+ compare-and-swap after the slab for it is published. Removed items go on a
+ Treiber stack of item indices, which are tagged with a counter in the top half
+ of the word against the ABA problem.
+
+ Every item carries a word for the stack. There is no compaction; the memory
+ is only returned on <fn:<P>lockfree_>.
+
+ @param[POOL_NAME, POOL_TYPE]
+ The same as the <tag:<P>pool> that was instantiated before; required.
+
+ @param[POOL_LOCKFREE_BASE]
+ The capacity of the first slab; default 8.
+
+ @param[POOL_LOCKFREE_SLABS]
+ The number of slabs; default 24. Also limited by the indices, which get half
+ of a `size_t`.
+
+ @param[POOL_TEST]
+ Unit testing framework <fn:<P>lockfree_test>, included in a separate header,
+ <../test/test_lockfree.h>. Any value.
+
+ @std C11 atomics, or GNU C89, through <src/atomic.h> */
+
+#if !defined(POOL_NAME) || !defined(POOL_TYPE)
+#error Name POOL_NAME undefined or tag type POOL_TYPE undefined.
+#endif
+#ifndef POOL_H
+#error Include <src/pool.h> first, with the same POOL_NAME and POOL_TYPE.
+#endif
+
+#ifndef LOCKFREE_H /* <!-- idempotent */
+#define LOCKFREE_H
+#include <stddef.h>
+#include "atomic.h" /** \include */
+/* An index in the bottom half of a word, and an ABA tag in the top half. */
+#define POOL_HALF (sizeof(size_t) * CHAR_BIT / 2)
+#define POOL_HALF_MASK (((size_t)1 << POOL_HALF) - 1)
+#endif /* idempotent --> */
+
+#if defined(PL_)
+#error Unexpected defines.
+#endif
+#define PL_(n) POOL_CAT(lockfree, P_(n))
+
+#ifndef POOL_LOCKFREE_BASE /* <!-- !base */
+#define POOL_LOCKFREE_BASE 8
+#endif /* !base --> */
+#ifndef POOL_LOCKFREE_SLABS /* <!-- !slabs */
+#define POOL_LOCKFREE_SLABS 24
+#endif /* !slabs --> */
+#if POOL_LOCKFREE_BASE < 1 || POOL_LOCKFREE_SLABS < 1 \
+	|| POOL_LOCKFREE_SLABS > 31
+#error POOL_LOCKFREE_BASE or POOL_LOCKFREE_SLABS out of range.
+#endif
+
+/* An item and it's link. While on the free stack, `link` is the next index
+ plus one; while in use, it is it's own index plus one. */
+struct PL_(node) { POOL_ATOMIC(size_t) link; PP_(type) data; };
+
+/** A lock-free pool. Zeroed memory is idle, but see <fn:<P>lockfree>. Not
+ copyable. */
+struct P_(lockfree) {
+	POOL_ATOMIC(size_t) free, size;
+	POOL_ATOMIC(struct PL_(node) *) slab[POOL_LOCKFREE_SLABS];
+};
+
+/** @return The slab of item index `i`, and the index in the slab in
+ `offset`. */
+static unsigned PL_(slab)(const size_t i, size_t *const offset) {
+	size_t q = i / POOL_LOCKFREE_BASE + 1;
+	unsigned k = 0;
+	while(q >>= 1) k++;
+	*offset = i - POOL_LOCKFREE_BASE * (((size_t)1 << k) - 1);
+	return k;
+}
+
+/** @return The number of indices that can be used. */
+static size_t PL_(max)(void) {
+	const size_t all
+		= POOL_LOCKFREE_BASE * (((size_t)1 << POOL_LOCKFREE_SLABS) - 1);
+	return all < POOL_HALF_MASK ? all : POOL_HALF_MASK;
+}
+
+/** @return The node at index `i` of `lf`, which must be in use. */
+static struct PL_(node) *PL_(at)(struct P_(lockfree) *const lf,
+	const size_t i) {
+	size_t offset;
+	const unsigned k = PL_(slab)(i, &offset);
+	struct PL_(node) *const slab = POOL_LOAD(&lf->slab[k], POOL_ACQUIRE);
+	assert(slab);
+	return slab + offset;
+}
+
+/** Publishes slab `k` of `lf` if it isn't already. If another thread beats us
+ to it, theirs is used. @return The slab. @throws[malloc] */
+static struct PL_(node) *PL_(grow)(struct P_(lockfree) *const lf,
+	const unsigned k) {
+	struct PL_(node) *slab, *expect = 0;
+	if((slab = POOL_LOAD(&lf->slab[k], POOL_ACQUIRE))) return slab;
+	if(!(slab = malloc(sizeof *slab * ((size_t)POOL_LOCKFREE_BASE << k))))
+		{ if(!errno) errno = ERANGE; return 0; }
+	while(!POOL_CAS(&lf->slab[k], &expect, slab, POOL_RELEASE, POOL_ACQUIRE))
+		if(expect) { free(slab); return expect; }
+	return slab;
+}
+
+/** Initializes `lf` to idle. @order \Theta(`POOL_LOCKFREE_SLABS`) @allow */
+static void P_(lockfree)(struct P_(lockfree) *const lf) {
+	unsigned k;
+	assert(lf);
+	POOL_STORE(&lf->free, 0, POOL_RELAXED);
+	POOL_STORE(&lf->size, 0, POOL_RELAXED);
+	for(k = 0; k < POOL_LOCKFREE_SLABS; k++)
+		POOL_STORE(&lf->slab[k], 0, POOL_RELAXED);
+}
+
+/** Destroys `lf` and returns it to idle; no other thread may be using it.
+ @allow */
+static void P_(lockfree_)(struct P_(lockfree) *const lf) {
+	unsigned k;
+	if(!lf) return;
+	for(k = 0; k < POOL_LOCKFREE_SLABS; k++)
+		free(POOL_LOAD(&lf->slab[k], POOL_ACQUIRE));
+	P_(lockfree)(lf);
+}
+
+/** Any thread may call this concurrently.
+ @return A new, un-initialized, element from `lf`. @throws[ERANGE]
+ All `POOL_LOCKFREE_SLABS` are used. @throws[malloc]
+ @order Lock-free; \O(1) without contention. @allow */
+static PP_(type) *P_(lockfree_new)(struct P_(lockfree) *const lf) {
+	struct PL_(node) *node, *slab;
+	size_t head, next, i, offset;
+	assert(lf);
+	/* Pop the free stack. */
+	head = POOL_LOAD(&lf->free, POOL_ACQUIRE);
+	while(head & POOL_HALF_MASK) {
+		i = (head & POOL_HALF_MASK) - 1, node = PL_(at)(lf, i);
+		/* May be stale, but then the tag will have changed. */
+		next = POOL_LOAD(&node->link, POOL_RELAXED) & POOL_HALF_MASK;
+		if(POOL_CAS(&lf->free, &head, ((head >> POOL_HALF) + 1) << POOL_HALF
+			| next, POOL_ACQUIRE, POOL_ACQUIRE)) {
+			POOL_STORE(&node->link, i + 1, POOL_RELAXED);
+			return &node->data;
+		}
+	}
+	/* Take a new one; the slab is published before it's counted. */
+	i = POOL_LOAD(&lf->size, POOL_RELAXED);
+	do {
+		if(i >= PL_(max)()) return errno = ERANGE, (PP_(type) *)0;
+		if(!(slab = PL_(grow)(lf, PL_(slab)(i, &offset)))) return 0;
+	} while(!POOL_CAS(&lf->size, &i, i + 1, POOL_RELAXED, POOL_RELAXED));
+	node = slab + offset;
+	POOL_STORE(&node->link, i + 1, POOL_RELAXED);
+	return &node->data;
+}
+
+/** Any thread may call this concurrently. Puts `data`, which must be from
+ <fn:<P>lockfree_new> on `lf` and not already removed, on the free stack.
+ @order Lock-free; \O(1) without contention. @allow */
+static void P_(lockfree_remove)(struct P_(lockfree) *const lf,
+	PP_(type) *const data) {
+	struct PL_(node) *const node = (struct PL_(node) *)(void *)
+		((char *)data - offsetof(struct PL_(node), data));
+	const size_t self = POOL_LOAD(&node->link, POOL_RELAXED);
+	size_t head;
+	assert(lf && data && self && self <= POOL_LOAD(&lf->size, POOL_RELAXED)
+		&& PL_(at)(lf, self - 1) == node);
+	head = POOL_LOAD(&lf->free, POOL_RELAXED);
+	do POOL_STORE(&node->link, head & POOL_HALF_MASK, POOL_RELAXED);
+	while(!POOL_CAS(&lf->free, &head, ((head >> POOL_HALF) + 1) << POOL_HALF
+		| self, POOL_RELEASE, POOL_RELAXED));
+}
+
+#ifdef POOL_TEST /* <!-- test */
+#include "../test/test_lockfree.h"
+#endif /* test --> */
+
+static void PL_(unused_lockfree_coda)(void);
+static void PL_(unused_lockfree)(void) {
+	P_(lockfree)(0); P_(lockfree_)(0); P_(lockfree_new)(0);
+	P_(lockfree_remove)(0, 0);
+	PL_(unused_lockfree_coda)();
+}
+static void PL_(unused_lockfree_coda)(void) { PL_(unused_lockfree)(); }
+
+#undef PL_
+#undef POOL_NAME
+#undef POOL_TYPE
+#undef POOL_LOCKFREE_BASE
+#undef POOL_LOCKFREE_SLABS
+#ifdef POOL_TEST
+#undef POOL_TEST
+#endif
@@ -0,0 +1,259 @@
+/** @license 2021 Neil Edelman, distributed under the terms of the
+ [MIT License](https://opensource.org/licenses/MIT).
+
+ @abstract Header <src/magazine.h> depends on <src/pool.h>, instantiated
+ before with the same `POOL_NAME` and `POOL_TYPE`, and `pthread`; examples
+ <test/test_pool.c>.
+
+ @subtitle Magazines over a shared pool
+
+ <tag:<P>depot> is a <tag:<P>pool> shared between threads behind a mutex,
+ with the magazine layer of <Bonwick, 1994>. Each thread has a
+ <tag:<P>cache> of two magazines, which are stacks of free items. A thread
+ only takes the lock when both are exhausted, to exchange a magazine with the
+ depot, so allocation and removal touch shared state about once every
+ `POOL_MAGAZINE` operations.
+
+ Items in magazines are allocated as far as the pool is concerned; they go
+ back to the pool on <fn:<P>depot_reap>.
+
+ @param[POOL_NAME, POOL_TYPE]
+ The same as the <tag:<P>pool> that was instantiated before; required.
+
+ @param[POOL_MAGAZINE]
+ The number of items in a magazine; default 32.
+
+ @param[POOL_TEST]
+ Unit testing framework <fn:<P>magazine_test>, included in a separate header,
+ <../test/test_magazine.h>. Any value.
+
+ @std C89 and POSIX threads */
+
+#if !defined(POOL_NAME) || !defined(POOL_TYPE)
+#error Name POOL_NAME undefined or tag type POOL_TYPE undefined.
+#endif
+#ifndef POOL_H
+#error Include <src/pool.h> first, with the same POOL_NAME and POOL_TYPE.
+#endif
+
+#ifndef MAGAZINE_H /* <!-- idempotent */
+#define MAGAZINE_H
+#include <pthread.h>
+#endif /* idempotent --> */
+
+#if defined(PM_)
+#error Unexpected defines.
+#endif
+#define PM_(n) POOL_CAT(magazine, P_(n))
+
+#ifndef POOL_MAGAZINE /* <!-- !size */
+#define POOL_MAGAZINE 32
+#endif /* !size --> */
+#if POOL_MAGAZINE < 1
+#error POOL_MAGAZINE must be positive.
+#endif
+
+/* A stack of `size` free items. */
+struct PM_(magazine) {
+	struct PM_(magazine) *next;
+	size_t size;
+	PP_(type) *round[POOL_MAGAZINE];
+};
+
+/** The pool and the magazines that are not in any cache, behind a lock.
+ Non-empty magazines are `full`; they may be only partially full if they came
+ from <fn:<P>cache_>. */
+struct P_(depot) {
+	pthread_mutex_t lock;
+	struct P_(pool) pool;
+	struct PM_(magazine) *full, *empty;
+};
+
+/** Owned by one thread and attached to a depot. The `loaded` magazine is the
+ one in use; `previous` is either full or empty, so a thread that alternates
+ allocation and removal doesn't thrash the depot. */
+struct P_(cache) {
+	struct P_(depot) *depot;
+	struct PM_(magazine) *loaded, *previous;
+};
+
+/** Locks `depot`. */
+static void PM_(lock)(struct P_(depot) *const depot) {
+	const int e = pthread_mutex_lock(&depot->lock);
+	assert(!e), (void)e;
+}
+
+/** Unlocks `depot`. */
+static void PM_(unlock)(struct P_(depot) *const depot) {
+	const int e = pthread_mutex_unlock(&depot->lock);
+	assert(!e), (void)e;
+}
+
+/** Has `depot` locked. @return An empty magazine from `depot` or a new one.
+ @throws[malloc] */
+static struct PM_(magazine) *PM_(empty)(struct P_(depot) *const depot) {
+	struct PM_(magazine) *m;
+	if((m = depot->empty)) depot->empty = m->next;
+	else if(!(m = malloc(sizeof *m))) { if(!errno) errno = ERANGE; return 0; }
+	m->next = 0, m->size = 0;
+	return m;
+}
+
+/** Has `depot` locked. Puts `m` on the full or empty list of `depot`. */
+static void PM_(give)(struct P_(depot) *const depot,
+	struct PM_(magazine) *const m) {
+	if(!m) return;
+	if(m->size) m->next = depot->full, depot->full = m;
+	else m->next = depot->empty, depot->empty = m;
+}
+
+/** Initializes `depot` to idle. A depot is not copyable.
+ @return Success. @throws[pthread_mutex_init] @allow */
+static int P_(depot)(struct P_(depot) *const depot) {
+	int e;
+	assert(depot);
+	depot->pool = P_(pool)(), depot->full = depot->empty = 0;
+	if((e = pthread_mutex_init(&depot->lock, 0))) return errno = e, 0;
+	return 1;
+}
+
+/** Destroys `depot` and everything in it; all the caches must be destroyed
+ before. @allow */
+static void P_(depot_)(struct P_(depot) *const depot) {
+	struct PM_(magazine) *m;
+	if(!depot) return;
+	while((m = depot->full)) depot->full = m->next, free(m);
+	while((m = depot->empty)) depot->empty = m->next, free(m);
+	P_(pool_)(&depot->pool);
+	pthread_mutex_destroy(&depot->lock);
+}
+
+/** Returns the items in the full magazines of `depot` to the pool, and frees
+ the magazines that are not in a cache.
+ @return Success. @throws[malloc, realloc] @order \O(`items`) @allow */
+static int P_(depot_reap)(struct P_(depot) *const depot) {
+	struct PM_(magazine) *m;
+	int success = 1;
+	assert(depot);
+	PM_(lock)(depot);
+	while((m = depot->full)) {
+		if(!P_(pool_remove_n)(&depot->pool, m->round, m->size))
+			{ success = 0; break; }
+		depot->full = m->next, free(m);
+	}
+	while((m = depot->empty)) depot->empty = m->next, free(m);
+	PM_(unlock)(depot);
+	return success;
+}
+
+/** @return A cache on `depot` for the thread that calls it, idle.
+ @order \Theta(1) @allow */
+static struct P_(cache) P_(cache)(struct P_(depot) *const depot) {
+	struct P_(cache) cache;
+	assert(depot);
+	cache.depot = depot, cache.loaded = cache.previous = 0;
+	return cache;
+}
+
+/** Gives the magazines of `cache` to it's depot, and returns it to idle.
+ @allow */
+static void P_(cache_)(struct P_(cache) *const cache) {
+	if(!cache || !cache->depot || !cache->loaded && !cache->previous) return;
+	PM_(lock)(cache->depot);
+	PM_(give)(cache->depot, cache->loaded);
+	PM_(give)(cache->depot, cache->previous);
+	PM_(unlock)(cache->depot);
+	cache->loaded = cache->previous = 0;
+}
+
+/** Both magazines of `cache` are empty or null; exchange with the depot, or
+ fill a magazine from the pool. @return An item. @throws[malloc] */
+static PP_(type) *PM_(new_slow)(struct P_(cache) *const cache) {
+	struct P_(depot) *const depot = cache->depot;
+	struct PM_(magazine) *m;
+	PP_(type) *x = 0;
+	if((m = cache->previous) && m->size) /* Swap. */
+		return cache->previous = cache->loaded, cache->loaded = m,
+		m->round[--m->size];
+	PM_(lock)(depot);
+	if((m = depot->full)) {
+		depot->full = m->next;
+		PM_(give)(depot, cache->previous);
+		cache->previous = cache->loaded, cache->loaded = m;
+	} else {
+		if(!(m = cache->loaded) && !(m = cache->loaded = PM_(empty)(depot))
+			|| !P_(pool_new_ptrs)(&depot->pool, m->round, POOL_MAGAZINE))
+			goto finally;
+		m->size = POOL_MAGAZINE;
+	}
+	x = m->round[--m->size];
+finally:
+	PM_(unlock)(depot);
+	return x;
+}
+
+/** Only in the thread that owns `cache`.
+ @return A new, un-initialized, item. @throws[malloc]
+ @order Amortized \O(1), locking once every `POOL_MAGAZINE`. @allow */
+static PP_(type) *P_(cache_new)(struct P_(cache) *const cache) {
+	struct PM_(magazine) *m;
+	assert(cache && cache->depot);
+	if((m = cache->loaded) && m->size) return m->round[--m->size];
+	return PM_(new_slow)(cache);
+}
+
+/** Both magazines of `cache` are full or null; exchange a full one for an
+ empty one from the depot. If there is no memory for a magazine, `data` goes
+ straight back to the pool. @return Success. @throws[malloc, realloc] */
+static int PM_(remove_slow)(struct P_(cache) *const cache,
+	PP_(type) *const data) {
+	struct P_(depot) *const depot = cache->depot;
+	struct PM_(magazine) *m;
+	int success;
+	if((m = cache->previous) && m->size < POOL_MAGAZINE) /* Swap. */
+		return cache->previous = cache->loaded, cache->loaded = m,
+		m->round[m->size++] = data, 1;
+	PM_(lock)(depot);
+	if(!(m = PM_(empty)(depot))) {
+		success = P_(pool_remove)(&depot->pool, data);
+	} else {
+		PM_(give)(depot, cache->previous);
+		cache->previous = cache->loaded, cache->loaded = m;
+		m->round[m->size++] = data, success = 1;
+	}
+	PM_(unlock)(depot);
+	return success;
+}
+
+/** Only in the thread that owns `cache`; puts `data`, which must be from the
+ same depot, but possibly from a different cache, in `cache`.
+ @return Success. @throws[malloc, realloc]
+ @order Amortized \O(1), locking once every `POOL_MAGAZINE`. @allow */
+static int P_(cache_remove)(struct P_(cache) *const cache,
+	PP_(type) *const data) {
+	struct PM_(magazine) *m;
+	assert(cache && cache->depot && data);
+	if((m = cache->loaded) && m->size < POOL_MAGAZINE)
+		return m->round[m->size++] = data, 1;
+	return PM_(remove_slow)(cache, data);
+}
+
+#ifdef POOL_TEST /* <!-- test */
+#include "../test/test_magazine.h"
+#endif /* test --> */
+
+static void PM_(unused_magazine_coda)(void);
+static void PM_(unused_magazine)(void) {
+	P_(depot)(0); P_(depot_)(0); P_(depot_reap)(0); P_(cache)(0);
+	P_(cache_)(0); P_(cache_new)(0); P_(cache_remove)(0, 0);
+	PM_(unused_magazine_coda)();
+}
+static void PM_(unused_magazine_coda)(void) { PM_(unused_magazine)(); }
+
+#undef PM_
+#undef POOL_NAME
+#undef POOL_TYPE
+#undef POOL_MAGAZINE
+#ifdef POOL_TEST
+#undef POOL_TEST
+#endif
@@ -0,0 +1,154 @@
+/** @license 2021 Neil Edelman, distributed under the terms of the
+ [MIT License](https://opensource.org/licenses/MIT).
+
+ @abstract Header <src/owner.h> depends on <src/pool.h>, instantiated before
+ with the same `POOL_NAME` and `POOL_TYPE`, `pthread`, and atomics; examples
+ <test/test_pool.c>.
+
+ @subtitle Pool owned by a thread
+
+ An <tag:<P>owner> is a <tag:<P>pool> that belongs to the thread that
+ created it. Only that thread allocates, but any thread can remove. Removal
+ from the owner thread goes straight to the pool; removal from any other
+ thread pushes the item on a lock-free multi-producer, single-consumer stack,
+ using the item itself for the link. The owner takes the whole stack at once
+ and removes it from the pool in batches, on <fn:<P>owner_new> or
+ <fn:<P>owner_drain>, so the pool itself is only touched by one thread.
+
+ @param[POOL_NAME, POOL_TYPE]
+ The same as the <tag:<P>pool> that was instantiated before; required. The
+ type must be at least as big as a pointer.
+
+ @param[POOL_OWNER_BATCH]
+ The number of items that are removed from the pool at once; default 64.
+
+ @param[POOL_TEST]
+ Unit testing framework <fn:<P>owner_test>, included in a separate header,
+ <../test/test_owner.h>. Any value.
+
+ @std C11 atomics, or GNU C89, through <src/atomic.h>, and POSIX threads */
+
+#if !defined(POOL_NAME) || !defined(POOL_TYPE)
+#error Name POOL_NAME undefined or tag type POOL_TYPE undefined.
+#endif
+#ifndef POOL_H
+#error Include <src/pool.h> first, with the same POOL_NAME and POOL_TYPE.
+#endif
+
+#ifndef OWNER_H /* <!-- idempotent */
+#define OWNER_H
+#include <pthread.h>
+#include "atomic.h" /** \include */
+#endif /* idempotent --> */
+
+#if defined(PO_)
+#error Unexpected defines.
+#endif
+#define PO_(n) POOL_CAT(owner, P_(n))
+
+#ifndef POOL_OWNER_BATCH /* <!-- !batch */
+#define POOL_OWNER_BATCH 64
+#endif /* !batch --> */
+#if POOL_OWNER_BATCH < 1
+#error POOL_OWNER_BATCH must be positive.
+#endif
+
+/* Removed items hold the next pointer of the remote stack. */
+typedef char PO_(link_fits)[sizeof(PP_(type)) >= sizeof(PP_(type) *) ? 1 : -1];
+
+/** A pool that is allocated by one thread and removed by any. Not copyable. */
+struct P_(owner) {
+	struct P_(pool) pool;
+	pthread_t thread;
+	POOL_ATOMIC(PP_(type) *) remote;
+};
+
+/** Pushes the chain `first` to `last` on the remote stack of `owner`. */
+static void PO_(push)(struct P_(owner) *const owner,
+	PP_(type) *const first, PP_(type) *const last) {
+	PP_(type) *head = POOL_LOAD(&owner->remote, POOL_RELAXED);
+	do memcpy(last, &head, sizeof head);
+	while(!POOL_CAS(&owner->remote, &head, first, POOL_RELEASE, POOL_RELAXED));
+}
+
+/** Initializes `owner` to idle, owned by the calling thread. @allow */
+static void P_(owner)(struct P_(owner) *const owner) {
+	assert(owner);
+	owner->pool = P_(pool)();
+	owner->thread = pthread_self();
+	POOL_STORE(&owner->remote, 0, POOL_RELAXED);
+}
+
+/** Destroys `owner` and returns it to idle; removal from other threads must
+ have stopped. @allow */
+static void P_(owner_)(struct P_(owner) *const owner) {
+	if(!owner) return;
+	P_(pool_)(&owner->pool);
+	POOL_STORE(&owner->remote, 0, POOL_RELAXED);
+}
+
+/** Only in the owner thread; removes from the pool of `owner` everything
+ that other threads have removed. @return Success; on failure, the rest stay
+ in the queue. @throws[malloc, realloc] @order \O(`remote`) @allow */
+static int P_(owner_drain)(struct P_(owner) *const owner) {
+	PP_(type) *x, *last, *batch[POOL_OWNER_BATCH];
+	size_t n;
+	assert(owner && pthread_equal(owner->thread, pthread_self()));
+	if(!POOL_LOAD(&owner->remote, POOL_RELAXED)
+		|| !(x = POOL_EXCHANGE(&owner->remote, 0, POOL_ACQUIRE))) return 1;
+	while(x) {
+		for(n = 0; x && n < POOL_OWNER_BATCH; n++)
+			last = batch[n] = x, memcpy(&x, x, sizeof x);
+		if(!P_(pool_remove_n)(&owner->pool, batch, n)) {
+			/* The chain from `batch[0]` is intact. */
+			while(x) last = x, memcpy(&x, x, sizeof x);
+			PO_(push)(owner, batch[0], last);
+			return 0;
+		}
+	}
+	return 1;
+}
+
+/** Only in the owner thread. Drains `owner` if other threads have removed
+ anything, and then allocates.
+ @return A new, un-initialized, element from `owner`.
+ @throws[ERANGE, malloc] @order Amortized \O(1) @allow */
+static PP_(type) *P_(owner_new)(struct P_(owner) *const owner) {
+	assert(owner && pthread_equal(owner->thread, pthread_self()));
+	/* If it fails, they are still queued, and the pool may yet have room. */
+	if(POOL_LOAD(&owner->remote, POOL_RELAXED)) P_(owner_drain)(owner);
+	return P_(pool_new)(&owner->pool);
+}
+
+/** Any thread may remove `data`, which must be from <fn:<P>owner_new> on
+ `owner`. In the owner thread, it's removed from the pool; in any other, it's
+ queued for the owner. @return Success. @throws[realloc] Only the owner thread,
+ and only the free-heap. @order Lock-free; \O(1) from other threads. @allow */
+static int P_(owner_remove)(struct P_(owner) *const owner,
+	PP_(type) *const data) {
+	assert(owner && data);
+	if(pthread_equal(owner->thread, pthread_self()))
+		return P_(pool_remove)(&owner->pool, data);
+	PO_(push)(owner, data, data);
+	return 1;
+}
+
+#ifdef POOL_TEST /* <!-- test */
+#include "../test/test_owner.h"
+#endif /* test --> */
+
+static void PO_(unused_owner_coda)(void);
+static void PO_(unused_owner)(void) {
+	P_(owner)(0); P_(owner_)(0); P_(owner_drain)(0); P_(owner_new)(0);
+	P_(owner_remove)(0, 0);
+	PO_(unused_owner_coda)();
+}
+static void PO_(unused_owner_coda)(void) { PO_(unused_owner)(); }
+
+#undef PO_
+#undef POOL_NAME
+#undef POOL_TYPE
+#undef POOL_OWNER_BATCH
+#ifdef POOL_TEST
+#undef POOL_TEST
+#endif
@@ -0,0 +1,227 @@
+/** @license 2021 Neil Edelman, distributed under the terms of the
+ [MIT License](https://opensource.org/licenses/MIT).
+
+ @abstract Header <src/percpu.h> depends on <src/pool.h>, instantiated
+ before with the same `POOL_NAME` and `POOL_TYPE`, `pthread`, and atomics;
+ examples <test/test_pool.c>.
+
+ @subtitle Per-CPU shards over a shared pool
+
+ A <tag:<P>percpu> puts a shard per CPU in front of a <tag:<P>pool> behind a
+ mutex. A shard is a stack of up to `POOL_PERCPU` free items with it's own
+ spinlock. Allocation and removal only touch the shard of the CPU that the
+ thread is running on; half a shard goes to or comes from the pool when it is
+ empty or full. Unlike a cache per thread, the memory held is bounded by the
+ number of CPUs, not the number of threads.
+
+ The CPU is read from the restartable sequences area that glibc 2.35 and
+ later registers with Linux, and otherwise from `sched_getcpu`. The critical
+ sections are longer than an `rseq` sequence can hold, so the shard lock
+ stays; it is only contended when a thread migrates or is preempted while
+ holding it.
+
+ @param[POOL_NAME, POOL_TYPE]
+ The same as the <tag:<P>pool> that was instantiated before; required.
+
+ @param[POOL_PERCPU]
+ The number of items a shard holds; default 64.
+
+ @param[POOL_TEST]
+ Unit testing framework <fn:<P>percpu_test>, included in a separate header,
+ <../test/test_percpu.h>. Any value.
+
+ @std C11 atomics, or GNU C89, through <src/atomic.h>, and POSIX threads */
+
+#if !defined(POOL_NAME) || !defined(POOL_TYPE)
+#error Name POOL_NAME undefined or tag type POOL_TYPE undefined.
+#endif
+#ifndef POOL_H
+#error Include <src/pool.h> first, with the same POOL_NAME and POOL_TYPE.
+#endif
+
+#ifndef PERCPU_H /* <!-- idempotent */
+#define PERCPU_H
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#include "atomic.h" /** \include */
+#if defined(__linux__) && defined(__GLIBC__) /* <!-- glibc */
+#if (__GLIBC__ > 2 || __GLIBC__ == 2 && __GLIBC_MINOR__ >= 35) \
+	&& defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11 \
+	&& (defined(__x86_64__) || defined(__aarch64__)) /* <!-- rseq */
+#include <sys/rseq.h>
+#define POOL_RSEQ
+#endif /* rseq --> */
+#ifndef __USE_GNU
+extern int sched_getcpu(void); /* Only declared with `_GNU_SOURCE`. */
+#endif
+#define POOL_GETCPU
+#endif /* glibc --> */
+/** @return The CPU that the thread is running on, (maybe stale by the time
+ it's used,) or some other number on failure. */
+static unsigned pool_cpu(void) {
+#ifdef POOL_RSEQ
+	if(__rseq_size) return ((const volatile struct rseq *)(const void *)
+		((const char *)__builtin_thread_pointer() + __rseq_offset))->cpu_id;
+#endif
+#ifdef POOL_GETCPU
+	{ const int cpu = sched_getcpu(); if(cpu >= 0) return (unsigned)cpu; }
+#endif
+	return 0;
+}
+#endif /* idempotent --> */
+
+#if defined(PC_)
+#error Unexpected defines.
+#endif
+#define PC_(n) POOL_CAT(percpu, P_(n))
+
+#ifndef POOL_PERCPU /* <!-- !size */
+#define POOL_PERCPU 64
+#endif /* !size --> */
+#if POOL_PERCPU < 2
+#error POOL_PERCPU must be at least two.
+#endif
+
+/* A stack of `size` free items, on a cache-line of it's own. */
+struct PC_(shard) {
+	POOL_ATOMIC(int) lock;
+	size_t size;
+	PP_(type) *round[POOL_PERCPU];
+	char unshared[64];
+};
+
+/** A pool behind a lock with a shard per CPU in front. Not copyable. */
+struct P_(percpu) {
+	pthread_mutex_t lock;
+	struct P_(pool) pool;
+	size_t shards;
+	struct PC_(shard) *shard;
+};
+
+/** @return The shard of `pc` for the CPU we are on, locked. */
+static struct PC_(shard) *PC_(lock)(struct P_(percpu) *const pc) {
+	struct PC_(shard) *const s = pc->shard + pool_cpu() % pc->shards;
+	while(POOL_EXCHANGE(&s->lock, 1, POOL_ACQUIRE))
+		while(POOL_LOAD(&s->lock, POOL_RELAXED)) sched_yield();
+	return s;
+}
+
+/** Unlocks `s`. */
+static void PC_(unlock)(struct PC_(shard) *const s)
+	{ POOL_STORE(&s->lock, 0, POOL_RELEASE); }
+
+/** Initializes `pc` with `shards`, or, if zero, one for each CPU
+ configured. @return Success. @throws[malloc, pthread_mutex_init] @allow */
+static int P_(percpu)(struct P_(percpu) *const pc, size_t shards) {
+	long cpus;
+	size_t i;
+	int e;
+	assert(pc);
+	if(!shards) shards = (cpus = sysconf(_SC_NPROCESSORS_CONF)) > 0
+		? (size_t)cpus : 1;
+	pc->pool = P_(pool)(), pc->shards = 0;
+	if(!(pc->shard = malloc(sizeof *pc->shard * shards)))
+		{ if(!errno) errno = ERANGE; return 0; }
+	if((e = pthread_mutex_init(&pc->lock, 0)))
+		{ free(pc->shard), pc->shard = 0; return errno = e, 0; }
+	for(i = 0; i < shards; i++)
+		POOL_STORE(&pc->shard[i].lock, 0, POOL_RELAXED), pc->shard[i].size = 0;
+	pc->shards = shards;
+	return 1;
+}
+
+/** Destroys `pc` and everything in it; no other thread may be using it.
+ @allow */
+static void P_(percpu_)(struct P_(percpu) *const pc) {
+	if(!pc || !pc->shard) return;
+	free(pc->shard), pc->shard = 0, pc->shards = 0;
+	P_(pool_)(&pc->pool);
+	pthread_mutex_destroy(&pc->lock);
+}
+
+/** Any thread may call this concurrently.
+ @return A new, un-initialized, element from `pc`. @throws[ERANGE, malloc]
+ @order Amortized \O(1), locking the pool once every `POOL_PERCPU / 2`.
+ @allow */
+static PP_(type) *P_(percpu_new)(struct P_(percpu) *const pc) {
+	struct PC_(shard) *s;
+	PP_(type) *x = 0;
+	assert(pc && pc->shards);
+	s = PC_(lock)(pc);
+	if(!s->size) {
+		pthread_mutex_lock(&pc->lock);
+		if(P_(pool_new_ptrs)(&pc->pool, s->round, POOL_PERCPU / 2))
+			s->size = POOL_PERCPU / 2;
+		pthread_mutex_unlock(&pc->lock);
+		if(!s->size) goto finally;
+	}
+	x = s->round[--s->size];
+finally:
+	PC_(unlock)(s);
+	return x;
+}
+
+/** Any thread may call this concurrently. Removes `data`, which must be from
+ <fn:<P>percpu_new> on `pc`, possibly on another CPU.
+ @return Success. @throws[malloc, realloc]
+ @order Amortized \O(1), locking the pool once every `POOL_PERCPU / 2`.
+ @allow */
+static int P_(percpu_remove)(struct P_(percpu) *const pc,
+	PP_(type) *const data) {
+	struct PC_(shard) *s;
+	int success = 1;
+	assert(pc && pc->shards && data);
+	s = PC_(lock)(pc);
+	if(s->size == POOL_PERCPU) {
+		pthread_mutex_lock(&pc->lock);
+		if(P_(pool_remove_n)(&pc->pool,
+			s->round + POOL_PERCPU / 2, POOL_PERCPU - POOL_PERCPU / 2))
+			s->size = POOL_PERCPU / 2;
+		else
+			success = P_(pool_remove)(&pc->pool, data);
+		pthread_mutex_unlock(&pc->lock);
+	}
+	if(s->size < POOL_PERCPU) s->round[s->size++] = data;
+	PC_(unlock)(s);
+	return success;
+}
+
+/** Returns all the items in the shards of `pc` to the pool.
+ @return Success. @throws[malloc, realloc] @order \O(`shards`) @allow */
+static int P_(percpu_flush)(struct P_(percpu) *const pc) {
+	struct PC_(shard) *s;
+	size_t i;
+	int success = 1;
+	assert(pc);
+	for(i = 0; i < pc->shards; i++) {
+		s = pc->shard + i;
+		while(POOL_EXCHANGE(&s->lock, 1, POOL_ACQUIRE)) sched_yield();
+		pthread_mutex_lock(&pc->lock);
+		if(P_(pool_remove_n)(&pc->pool, s->round, s->size)) s->size = 0;
+		else success = 0;
+		pthread_mutex_unlock(&pc->lock);
+		PC_(unlock)(s);
+	}
+	return success;
+}
+
+#ifdef POOL_TEST /* <!-- test */
+#include "../test/test_percpu.h"
+#endif /* test --> */
+
+static void PC_(unused_percpu_coda)(void);
+static void PC_(unused_percpu)(void) {
+	P_(percpu)(0, 0); P_(percpu_)(0); P_(percpu_new)(0);
+	P_(percpu_remove)(0, 0); P_(percpu_flush)(0);
+	PC_(unused_percpu_coda)();
+}
+static void PC_(unused_percpu_coda)(void) { PC_(unused_percpu)(); }
+
+#undef PC_
+#undef POOL_NAME
+#undef POOL_TYPE
+#undef POOL_PERCPU
+#ifdef POOL_TEST
+#undef POOL_TEST
+#endif
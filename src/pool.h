@@ -21,6 +21,159 @@
  <typedef:<PP>type>, associated therewith; required. `<PP>` is private, whose
  names are prefixed in a manner to avoid collisions.
 
+ @param[POOL_FREE_LIST]
+ Slab zero keeps a stack of removed items threaded through the removed items
+ themselves, instead of a free-heap. It takes no extra memory, and removal is
+ \O(1) and cannot fail; however, the tail only shrinks while the most recently
+ removed are exposed. Requires `sizeof(POOL_TYPE) >= sizeof(size_t)`.
+
+ @param[POOL_FREE_BITMAP]
+ Slab zero keeps a two-level bitmap of removed items instead of a free-heap,
+ one bit per item of capacity, allocated with the slab. Removal is \O(1) and
+ cannot fail, new items are always the lowest removed index, and the tail
+ shrinks over every exposed removed item. The summary scan uses `SSE2` or
+ `AVX2` if the compiler targets them.
+
+ @param[POOL_RADIX]
+ Defined as the base-two logarithm of an alignment, every slab is allocated
+ at an address aligned to `1 << POOL_RADIX` bytes, and a radix table keyed by
+ the address bits above that maps to the slab. Finding the slab of an item on
+ removal is then three loads instead of a binary search. Each slab has up to
+ an alignment of slack; `16`, (`64KiB`,) is reasonable. Addresses must fit in
+ `POOL_ADDRESS_BITS`, by default, `48` on `64`-bit systems.
+
+ @param[POOL_BLOCK]
+ Defined as the base-two logarithm of a block size, every slab is in a block
+ aligned to it's size, after a header that has the capacity and the index of
+ the slot. Finding the slab of an item on removal is rounding the address
+ down. Slabs stop growing at one block, so requests for more items than fit
+ in a block fail with `ERANGE`. Incompatible with `POOL_RADIX`.
+
+ @param[POOL_INLINE_SLOTS]
+ The slots are a fixed table in the pool instead of a dynamic array, so an
+ idle pool has no allocation for them. Slabs grow geometrically, so they are
+ bounded by twice the bits in `size_t`. Finding the slab of an item on
+ removal counts the slabs that are at or below it, using `AVX2` if the
+ compiler targets it, instead of a binary search. Incompatible with
+ `POOL_RADIX` and `POOL_BLOCK`.
+
+ @param[POOL_HUGE]
+ Defined as the base-two logarithm of a huge page, every slab is mapped with
+ `mmap` in whole huge pages, aligned, after a header that has the size of the
+ mapping; `21`, (`2MiB`,) on `x86_64`. It is first tried with `MAP_HUGETLB`,
+ which only succeeds if the system has huge pages reserved, and otherwise the
+ slab is advised `MADV_HUGEPAGE` for transparent huge pages. The capacity of
+ a new slab is rounded up so that it fills it's pages, and empty secondary
+ slabs are unmapped. This is for large pools that are limited by misses in the
+ TLB; every slab is at least one huge page. Needs `MAP_ANONYMOUS`, which, in
+ `glibc`, is only declared with `_DEFAULT_SOURCE` or similar. Incompatible
+ with `POOL_RADIX` and `POOL_BLOCK`.
+
+ @param[POOL_RESERVE]
+ Defined as the base-two logarithm of the bytes of address space that the
+ pool reserves with `mmap` the first time it needs memory; `36`, (`64GiB`,)
+ is not unreasonable on `64`-bit systems. Pages are committed with
+ `mprotect` as slab zero grows, in place, so there is only ever one slab and
+ it's free-heap, -list, or -bitmap is kept. Finding the slab of an item is
+ trivial. Growing past the reservation fails with `ERANGE`. Needs
+ `MAP_ANONYMOUS`, like `POOL_HUGE`, with which it is incompatible, as well as
+ `POOL_RADIX` and `POOL_BLOCK`.
+
+ @param[POOL_ALIGN]
+ A power of two that slabs are aligned to, and that every item is padded to a
+ multiple of, so items are `POOL_ALIGN` aligned. It must be at least the
+ alignment of `POOL_TYPE`. Consecutive items from <fn:<P>pool_new_n> are then
+ the padded size apart, not `sizeof(POOL_TYPE)`. Slabs are allocated with the
+ slack of the alignment and a pointer before them. Incompatible with
+ `POOL_BLOCK` and `POOL_HUGE`, and no more than the granule of `POOL_RADIX`.
+
+ @param[POOL_CACHELINE_ISOLATE]
+ Any value; the same as a `POOL_ALIGN` of at least `64`, the size of a cache
+ line, so no two items share a line, and there is no false sharing between
+ items that are used by different threads.
+
+ @param[POOL_COLOUR]
+ The number of colours of <Bonwick, 1994>; each new slab starts that many
+ cache-lines, modulo `POOL_COLOUR`, further into it's allocation than the
+ last, (lines of `POOL_ALIGN` if it's more,) starting from a colour that
+ depends on the pool. Otherwise, slabs all start at the same offset from the
+ alignment of `malloc`, and the same items in different slabs compete for the
+ same sets of the cache. Slabs are allocated with the slack of all the
+ colours, and the allocation and colour before them. Incompatible with
+ `POOL_RADIX`, `POOL_BLOCK`, `POOL_HUGE`, and `POOL_RESERVE`.
+
+ @param[POOL_RETAIN]
+ The number of empty slabs that the pool keeps, instead of freeing them as
+ soon as they are empty. When it needs a new slab zero, the retained slab with
+ the most capacity is used, as long as the request fits, before allocating.
+ This is for loads that go back and forth over the boundary of a slab, which
+ would otherwise allocate and free the same memory each time. With
+ `POOL_INLINE_SLOTS`, once half the table is used, a retained slab has to be
+ at least what slab zero would grow to. Incompatible with `POOL_RESERVE`,
+ which has only slab zero.
+
+ @param[POOL_RETAIN_BYTES]
+ With `POOL_RETAIN`, the most bytes of retained slabs; the oldest are freed
+ to make room. By default, only the number is limited.
+
+ @param[POOL_RETAIN_DECAY]
+ With `POOL_RETAIN`, the number of slab events, a new slab zero or an empty
+ slab, that a retained slab lasts unused before it's freed; default `32`.
+
+ @param[POOL_PAGE_FREE]
+ Defined as the base-two logarithm of a page, `12` on most systems, slab zero
+ keeps a count of live items on each page, and a page that is wholly in the
+ slab and has none is given back to the system with `madvise`, `MADV_FREE`
+ if it has it, otherwise `MADV_DONTNEED`. The next time an item on it is
+ used, the page faults back in. This is for long-lived pools where the
+ removed items are scattered, so slab zero doesn't shrink from the tail. A
+ page smaller than that of the system is harmless, but nothing is given
+ back. Needs `MADV_DONTNEED`, like `MAP_ANONYMOUS` in `POOL_HUGE`.
+ Incompatible with `POOL_FREE_LIST`, which is in the removed items.
+
+ @param[POOL_LIMIT]
+ Any value; the pool has a limit on the bytes it takes, see
+ <fn:<P>pool_set_limit>, and a callback to reclaim memory before it fails,
+ see <fn:<P>pool_set_reclaim>.
+
+ @param[POOL_STATS]
+ Any value; all the pools of this type count how many new items come from
+ the free-heap and the tail, how many times slab zero is checked for room
+ and grows, how many removes are in slab zero and in secondary slabs, how
+ many secondary slabs are freed, and how many steps the search for a slot
+ takes. See <fn:<P>pool_counters>. They are relaxed atomic adds, so the
+ concurrent pools can count, and need atomics, see <src/atomic.h>. Without
+ it, nothing is counted.
+
+ @param[POOL_TRACE]
+ Any value; a pool can record the items it makes and removes to a
+ <tag:pool_trace> in <src/trace.h>, see <fn:<P>pool_set_trace>, to replay
+ real traffic later, as in <timing/test/replay.c>. Needs `CLOCK_MONOTONIC`.
+
+ @param[POOL_SAMPLE]
+ Any value; a pool can take a backtrace of about one in a tunable number of
+ the items it makes, and attribute the live ones to call stacks, in a
+ <tag:pool_sample> of <src/sample.h>, see <fn:<P>pool_set_sample>. Needs
+ <execinfo.h>.
+
+ @param[POOL_USDT]
+ Any value; user-level static probes from <sys/sdt.h>, provider `pool`, for
+ `bpftrace` or `perf`. Each is a `nop` until it's attached to, and the first
+ argument points to the `POOL_NAME` as a string. `slab_new` and
+ `slab_recycle`, with the capacity of the new slab zero and of the old one,
+ are when slab zero grows; `slab_free`, with the capacity and the slabs
+ left, is when a secondary slab is freed; `free0_grow`, with the size and
+ the capacity, is when the free-heap is reallocated; and `tail_shrink`, with
+ the size of slab zero before and after, is when removing exposes the tail.
+
+ @param[POOL_ALLOC, POOL_REALLOC, POOL_FREE]
+ Functions implementing <typedef:<PP>alloc_fn>, <typedef:<PP>realloc_fn>, and
+ <typedef:<PP>free_fn> that replace the standard library for all the memory
+ of the pool: the slabs, unless `POOL_HUGE` or `POOL_RESERVE`, the slots, the
+ free-heap, and the slot maps. They are passed the `context` of the pool, see
+ <fn:<P>pool_context>. Both the slots and the free-heap are then their own
+ instantiations. All or none.
+
  @depend [array](https://github.com/neil-edelman/array)
  @depend [heap](https://github.com/neil-edelman/heap)
  @std C89; however, when compiling for segmented memory models, C99 with
@@ -52,6 +205,9 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <errno.h>
+#include <limits.h>
+#include <string.h>
+#include <stddef.h>
 #if defined(POOL_CAT_) || defined(POOL_CAT) || defined(P_) || defined(PP_)
 #error Unexpected defines.
 #endif
@@ -62,6 +218,11 @@
 #define PP_(n) POOL_CAT(pool, P_(n))
 /** @return An order on `a`, `b` which specifies a max-heap. */
 static int pool_index_compare(const size_t a, const size_t b) { return a < b; }
+/** @return Ascending order of indices `a`, `b`. @implements `qsort` */
+static int pool_index_order(const void *const a, const void *const b) {
+	const size_t x = *(const size_t *)a, y = *(const size_t *)b;
+	return (x > y) - (x < y);
+}
 #define HEAP_NAME poolfree
 #define HEAP_TYPE size_t
 #define HEAP_COMPARE &pool_index_compare
@@ -69,10 +230,77 @@ static int pool_index_compare(const size_t a, const size_t b) { return a < b; }
 #if !defined(__STDC__) || !defined(__STDC_VERSION__) \
 	|| __STDC_VERSION__ < 199901L /* < C99 */
 #define POOL_PTR (const void *)
+#define POOL_ADDRESS(x) ((unsigned long)(const void *)(x))
+#define POOL_ADDRESS_MAX ULONG_MAX
 #else /* < C99 --><!-- >= C99 */
 #include <stdint.h>
 #define POOL_PTR (const uintptr_t)(const void *)
+#define POOL_ADDRESS(x) ((uintptr_t)(const void *)(x))
+#define POOL_ADDRESS_MAX UINTPTR_MAX
 #endif /* >= C99 --> */
+#ifndef POOL_ADDRESS_BITS /* <!-- !bits: significant bits of an address. */
+#if POOL_ADDRESS_MAX > 0xffffffff
+#define POOL_ADDRESS_BITS 48
+#else
+#define POOL_ADDRESS_BITS 32
+#endif
+#endif /* !bits --> */
+/* Before every slab in `POOL_RADIX` is where it was allocated and how big. */
+struct pool_radix_head { void *raw; size_t capacity; };
+/* At the start of every block in `POOL_BLOCK`, followed by the slab. */
+struct pool_block_head { void *raw; size_t capacity, slot; };
+/* At the start of every mapping in `POOL_HUGE`, followed by the slab. */
+struct pool_huge_head { size_t bytes, capacity; };
+#if defined(__AVX2__)
+#include <immintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+/* A lane of `__m256i` that is a word; named once, so `-ansi -pedantic`
+ doesn't warn about `long long` every time it's used. */
+__extension__ typedef long long pool_lane;
+#endif
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+/* Bits in a word of the bitmap in `POOL_FREE_BITMAP`. */
+#define POOL_WORD_BIT (sizeof(unsigned long) * CHAR_BIT)
+/* Bitmap of removed items in slab-zero followed by a summary bitmap of which
+ words are non-zero. `hint` is a lower bound on the non-zero summary words. */
+struct pool_bitmap { unsigned long *bits; size_t size, hint; };
+/** @return The number of words that hold `n` bits. */
+static size_t pool_words(const size_t n)
+	{ return n / POOL_WORD_BIT + !!(n % POOL_WORD_BIT); }
+/** @return Index of the lowest set bit in non-zero `x`. */
+static unsigned pool_ctz(unsigned long x) {
+#if defined(__GNUC__) || defined(__clang__)
+	return assert(x), (unsigned)__builtin_ctzl(x);
+#else
+	unsigned n = 0;
+	assert(x);
+	while(!(x & 1)) x >>= 1, n++;
+	return n;
+#endif
+}
+/** @return Index of the first non-zero word in `w`, which has `n` words,
+ starting at `i`; there must be one. */
+static size_t pool_nonzero(const unsigned long *const w, size_t i,
+	const size_t n) {
+#if defined(__AVX2__)
+	const size_t lanes = sizeof(__m256i) / sizeof *w;
+	for( ; i + lanes <= n; i += lanes) {
+		const __m256i v = _mm256_loadu_si256((const __m256i *)(w + i));
+		if(!_mm256_testz_si256(v, v)) break;
+	}
+#elif defined(__SSE2__)
+	const size_t lanes = sizeof(__m128i) / sizeof *w;
+	const __m128i zero = _mm_setzero_si128();
+	for( ; i + lanes <= n; i += lanes) {
+		const __m128i v = _mm_loadu_si128((const __m128i *)(w + i));
+		if(_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero)) != 0xffff) break;
+	}
+#endif
+	while(assert(i < n), !w[i]) i++;
+	return i;
+}
 #endif /* idempotent --> */
 
 
@@ -91,11 +319,296 @@ static int pool_index_compare(const size_t a, const size_t b) { return a < b; }
 typedef POOL_TYPE PP_(type);
 typedef const POOL_TYPE PP_(type_c);
 
+#ifdef POOL_CACHELINE_ISOLATE /* <!-- isolate */
+#if !defined(POOL_ALIGN) || POOL_ALIGN < 64
+#define POOL_ALIGNMENT 64
+#else
+#define POOL_ALIGNMENT POOL_ALIGN
+#endif
+#elif defined(POOL_ALIGN) /* isolate --><!-- align */
+#define POOL_ALIGNMENT POOL_ALIGN
+#endif /* align --> */
+#ifdef POOL_ALIGNMENT /* <!-- padded */
+#if POOL_ALIGNMENT < 1 || POOL_ALIGNMENT & (POOL_ALIGNMENT - 1)
+#error POOL_ALIGN must be a power of two.
+#endif
+#if defined(POOL_BLOCK) || defined(POOL_HUGE)
+#error POOL_ALIGN is incompatible with POOL_BLOCK or POOL_HUGE.
+#endif
+#if defined(POOL_RADIX) && POOL_ALIGNMENT > 1 << POOL_RADIX
+#error POOL_ALIGN is more than the granule of POOL_RADIX.
+#endif
+/* The alignment of the type must divide the padded size. */
+struct PP_(align) { char c; PP_(type) data; };
+typedef char PP_(align_fits)[offsetof(struct PP_(align), data)
+	<= POOL_ALIGNMENT ? 1 : -1];
+/* Items are padded to a multiple of the alignment. */
+#define POOL_STRIDE ((sizeof(PP_(type)) + POOL_ALIGNMENT - 1) \
+	& ~(size_t)(POOL_ALIGNMENT - 1))
+/** @return Item `i` of `slab`. */
+static PP_(type) *PP_(at)(const PP_(type) *const slab, const size_t i)
+	{ return (PP_(type) *)(void *)((char *)(void *)slab + POOL_STRIDE * i); }
+/** @return The index of `x` in `slab`. */
+static size_t PP_(index)(const PP_(type) *const slab,
+	const PP_(type) *const x)
+	{ return (size_t)((const char *)x - (const char *)slab) / POOL_STRIDE; }
+#else /* padded --><!-- packed */
+#define POOL_STRIDE sizeof(PP_(type))
+/** @return Item `i` of `slab`. */
+static PP_(type) *PP_(at)(const PP_(type) *const slab, const size_t i)
+	{ return (PP_(type) *)(void *)(slab + i); }
+/** @return The index of `x` in `slab`. */
+static size_t PP_(index)(const PP_(type) *const slab,
+	const PP_(type) *const x) { return (size_t)(x - slab); }
+#endif /* packed --> */
+
 /* Goes into a slab-sorted array. */
-struct PP_(slot) { size_t size; PP_(type) *slab; };
+struct PP_(slot) {
+	size_t size;
+	PP_(type) *slab;
+	size_t capacity; /* So it can be counted when it's released. */
+};
+
+#if defined(POOL_ALLOC) || defined(POOL_REALLOC) || defined(POOL_FREE)
+#if !defined(POOL_ALLOC) || !defined(POOL_REALLOC) || !defined(POOL_FREE)
+#error POOL_ALLOC, POOL_REALLOC, and POOL_FREE go together.
+#endif
+#define POOL_ALLOCATOR /* The pool stores a context for them. */
+/** Returns `size` bytes with `context`, like `malloc`. */
+typedef void *(*PP_(alloc_fn))(void *context, size_t size);
+/** Returns `data` resized to `size` bytes with `context`, like `realloc`. */
+typedef void *(*PP_(realloc_fn))(void *context, void *data, size_t size);
+/** Frees `data`, which may be null, with `context`, like `free`. */
+typedef void (*PP_(free_fn))(void *context, void *data);
+/* Check that they are functions implementing the above. */
+static const PP_(alloc_fn) PP_(alloc_hook) = (POOL_ALLOC);
+static const PP_(realloc_fn) PP_(realloc_hook) = (POOL_REALLOC);
+static const PP_(free_fn) PP_(free_hook) = (POOL_FREE);
+/* The arrays get their pool back from their address. */
+#ifndef POOL_INLINE_SLOTS
+static void *PP_(slots_realloc)(const void *, void *, size_t);
+static void PP_(slots_free)(const void *, void *);
+#endif
+#if !defined(POOL_FREE_LIST) && !defined(POOL_FREE_BITMAP)
+static void *PP_(heap_realloc)(const void *, void *, size_t);
+static void PP_(heap_free)(const void *, void *);
+#endif
+#endif
+#ifdef POOL_INLINE_SLOTS /* <!-- inline */
+#if defined(POOL_RADIX) || defined(POOL_BLOCK)
+#error POOL_INLINE_SLOTS is incompatible with POOL_RADIX or POOL_BLOCK.
+#endif
+/* Capacities grow by more than the square root of two each slab. */
+#define POOL_SLOT_MAX (sizeof(size_t) * CHAR_BIT * 2)
+/* The subset of the array interface that the pool uses, in a fixed table. */
+struct PP_(slot_array) { struct PP_(slot) data[POOL_SLOT_MAX]; size_t size; };
+/** @return An empty table. */
+static struct PP_(slot_array) PP_(slot_array)(void)
+	{ struct PP_(slot_array) a; a.size = 0; return a; }
+/** The table of `a` has no memory. */
+static void PP_(slot_array_)(struct PP_(slot_array) *const a) { a->size = 0; }
+/** @return Whether there is space for `n` more slots in `a`.
+ @throws[ERANGE] */
+static int PP_(slot_array_buffer)(struct PP_(slot_array) *const a,
+	const size_t n) {
+	assert(a && a->size <= POOL_SLOT_MAX);
+	if(n > POOL_SLOT_MAX - a->size) return errno = ERANGE, 0;
+	return 1;
+}
+/** Opens `n` slots at `at` in `a`; there must be space.
+ @return The first new slot. */
+static struct PP_(slot) *PP_(slot_array_insert)(struct PP_(slot_array) *const
+	a, const size_t n, const size_t at) {
+	assert(a && at <= a->size && n <= POOL_SLOT_MAX - a->size);
+	memmove(a->data + at + n, a->data + at, sizeof *a->data * (a->size - at));
+	a->size += n;
+	return a->data + at;
+}
+/** Removes `slot` from `a`. */
+static void PP_(slot_array_remove)(struct PP_(slot_array) *const a,
+	struct PP_(slot) *const slot) {
+	const size_t at = (size_t)(slot - a->data);
+	assert(a && at < a->size);
+	memmove(slot, slot + 1, sizeof *a->data * (--a->size - at));
+}
+#else /* inline --><!-- array */
 #define ARRAY_NAME PP_(slot)
 #define ARRAY_TYPE struct PP_(slot)
+#ifdef POOL_ALLOCATOR
+#define ARRAY_REALLOC PP_(slots_realloc)
+#define ARRAY_FREE PP_(slots_free)
+#endif
 #include "array.h"
+#endif /* array --> */
+
+#if defined(POOL_FREE_LIST) && defined(POOL_FREE_BITMAP)
+#error Only one of POOL_FREE_LIST or POOL_FREE_BITMAP.
+#endif
+#ifdef POOL_RADIX /* <!-- radix */
+#if POOL_RADIX < 4 || POOL_RADIX >= POOL_ADDRESS_BITS
+#error POOL_RADIX out of range.
+#endif
+/* The granule index is split into three levels of the radix table. */
+#define POOL_RADIX_LEAF ((POOL_ADDRESS_BITS - POOL_RADIX) / 3)
+#define POOL_RADIX_MID ((POOL_ADDRESS_BITS - POOL_RADIX) / 3)
+#define POOL_RADIX_ROOT (POOL_ADDRESS_BITS - POOL_RADIX - 2 * POOL_RADIX_LEAF)
+#define POOL_RADIX_SHIFT (POOL_RADIX_LEAF + POOL_RADIX_MID)
+#define POOL_RADIX_MASK(bits) (((size_t)1 << (bits)) - 1)
+#endif /* radix --> */
+#ifdef POOL_BLOCK /* <!-- block */
+#ifdef POOL_RADIX
+#error Only one of POOL_RADIX or POOL_BLOCK.
+#endif
+#if POOL_BLOCK < 8 || POOL_BLOCK >= POOL_ADDRESS_BITS
+#error POOL_BLOCK out of range.
+#endif
+#define POOL_BLOCK_MASK (((size_t)1 << POOL_BLOCK) - 1)
+/* The header and the smallest slab must fit in a block. */
+typedef char PP_(block_fits)[(POOL_BLOCK_MASK + 1
+	- sizeof(struct pool_block_head)) / POOL_STRIDE
+	>= POOL_SLAB_MIN_CAPACITY ? 1 : -1];
+#endif /* block --> */
+#ifdef POOL_HUGE /* <!-- huge */
+#if defined(POOL_RADIX) || defined(POOL_BLOCK)
+#error POOL_HUGE is incompatible with POOL_RADIX or POOL_BLOCK.
+#endif
+#if POOL_HUGE < 12 || POOL_HUGE > POOL_ADDRESS_BITS - 2
+#error POOL_HUGE out of range.
+#endif
+#define POOL_HUGE_MASK (((size_t)1 << POOL_HUGE) - 1)
+#endif /* huge --> */
+#ifdef POOL_RESERVE /* <!-- reserve */
+#if defined(POOL_RADIX) || defined(POOL_BLOCK) || defined(POOL_HUGE)
+#error POOL_RESERVE is incompatible with POOL_RADIX, POOL_BLOCK, or POOL_HUGE.
+#endif
+#if POOL_RESERVE < 16 || POOL_RESERVE >= POOL_ADDRESS_BITS
+#error POOL_RESERVE out of range.
+#endif
+#include <unistd.h>
+#endif /* reserve --> */
+#ifdef POOL_PAGE_FREE /* <!-- page */
+#ifdef POOL_FREE_LIST
+#error POOL_PAGE_FREE is incompatible with POOL_FREE_LIST.
+#endif
+#if POOL_PAGE_FREE < 8 || POOL_PAGE_FREE > POOL_ADDRESS_BITS - 2
+#error POOL_PAGE_FREE out of range.
+#endif
+#define POOL_PAGE ((size_t)1 << POOL_PAGE_FREE)
+#endif /* page --> */
+#if defined(POOL_HUGE) || defined(POOL_RESERVE) \
+	|| defined(POOL_PAGE_FREE) /* <!-- mmap */
+#include <sys/mman.h>
+#if (defined(POOL_HUGE) || defined(POOL_RESERVE)) && !defined(MAP_ANONYMOUS)
+#error Mapping needs MAP_ANONYMOUS; define _DEFAULT_SOURCE before includes.
+#endif
+#if defined(POOL_PAGE_FREE) && !defined(MADV_DONTNEED)
+#error Pages need MADV_DONTNEED; define _DEFAULT_SOURCE before includes.
+#endif
+#endif /* mmap --> */
+#if defined(POOL_RADIX) || defined(POOL_BLOCK)
+#define POOL_SLOT_MAP /* Slot indices are stored and must follow shifts. */
+#endif
+#ifdef POOL_COLOUR /* <!-- colour */
+#if defined(POOL_SLOT_MAP) || defined(POOL_HUGE) || defined(POOL_RESERVE)
+#error POOL_COLOUR is incompatible with slabs that are placed.
+#endif
+#if POOL_COLOUR < 1
+#error POOL_COLOUR must be positive.
+#endif
+#if defined(POOL_ALIGNMENT) && POOL_ALIGNMENT > 64
+#define POOL_COLOUR_LINE POOL_ALIGNMENT
+#else
+#define POOL_COLOUR_LINE 64
+#endif
+#endif /* colour --> */
+#ifdef POOL_RETAIN /* <!-- retain */
+#ifdef POOL_RESERVE
+#error POOL_RETAIN is incompatible with POOL_RESERVE.
+#endif
+#if POOL_RETAIN < 1
+#error POOL_RETAIN must be positive.
+#endif
+#ifndef POOL_RETAIN_BYTES
+#define POOL_RETAIN_BYTES ((size_t)-1)
+#endif
+#ifndef POOL_RETAIN_DECAY
+#define POOL_RETAIN_DECAY 32
+#endif
+/* An empty slab that is kept, and the epoch when it was. */
+struct PP_(retained) { PP_(type) *slab; size_t capacity, epoch; };
+#elif defined(POOL_RETAIN_BYTES) \
+	|| defined(POOL_RETAIN_DECAY) /* retain --><!-- !retain */
+#error POOL_RETAIN_BYTES or POOL_RETAIN_DECAY without POOL_RETAIN.
+#endif /* !retain --> */
+#ifdef POOL_LIMIT /* <!-- limit */
+#ifdef ENOBUFS
+#define POOL_LIMIT_ERRNO ENOBUFS
+#else
+#define POOL_LIMIT_ERRNO EDOM
+#endif
+struct P_(pool);
+/** Called when `pool` can't grow for `n` items within it's limit, with the
+ `param` of <fn:<P>pool_set_reclaim>. It may remove items or
+ <fn:<P>pool_trim>, but not add to `pool`. @return Whether to try again. */
+typedef int (*PP_(reclaim_fn))(struct P_(pool) *pool, size_t n, void *param);
+#endif /* limit --> */
+#ifdef POOL_STATS /* <!-- stats */
+#include <stdio.h>
+#include "atomic.h" /** \include */
+/** Counts of the hot paths of all the pools of this type, from
+ <fn:<P>pool_counters>. */
+struct P_(pool_counters) {
+	size_t new_free0, new_tail; /* New items from each. */
+	size_t room, grow; /* Checks for room in slab zero, and slabs allocated. */
+	size_t remove0, remove_slab, release; /* Removes; slabs freed. */
+	size_t upper, upper_depth; /* Searches for a slot, and their steps. */
+};
+/* The counts shared between all the pools, and all the threads. */
+static struct {
+	POOL_ATOMIC(size_t) new_free0, new_tail, room, grow, remove0, remove_slab,
+		release, upper, upper_depth;
+} PP_(count);
+#define POOL_COUNT(c, n) \
+	((void)POOL_FETCH_ADD(&PP_(count).c, (size_t)(n), POOL_RELAXED))
+#else /* stats --><!-- !stats */
+#define POOL_COUNT(c, n) ((void)0)
+#endif /* !stats --> */
+#ifdef POOL_TRACE /* <!-- trace */
+#include "trace.h" /** \include */
+#endif /* trace --> */
+#ifdef POOL_SAMPLE /* <!-- sample */
+#include "sample.h" /** \include */
+#endif /* sample --> */
+#ifdef POOL_USDT /* <!-- usdt */
+#include <sys/sdt.h>
+#define POOL_PROBE_NAME_(n) #n
+#define POOL_PROBE_NAME(n) POOL_PROBE_NAME_(n)
+/* An array can't be an argument of <sys/sdt.h>, which casts to it's type. */
+static const char *const PP_(probe_name) = POOL_PROBE_NAME(POOL_NAME);
+#define POOL_PROBE(probe, a, b) STAP_PROBE3(pool, probe, PP_(probe_name), a, b)
+#else /* usdt --><!-- !usdt */
+#define POOL_PROBE(probe, a, b) ((void)0)
+#endif /* !usdt --> */
+#if defined(POOL_FREE_LIST) || defined(POOL_FREE_BITMAP)
+#define POOL_FREE_CONSTANT /* Slab-zero removal is constant and can't fail. */
+#elif defined(POOL_ALLOCATOR) /* constant --><!-- own heap */
+#define HEAP_NAME PP_(free0)
+#define HEAP_TYPE size_t
+#define HEAP_COMPARE &pool_index_compare
+#define HEAP_REALLOC PP_(heap_realloc)
+#define HEAP_FREE PP_(heap_free)
+#include "heap.h"
+#define PF_(n) POOL_CAT(PP_(free0), n)
+#else /* own heap --><!-- shared heap */
+#define PF_(n) POOL_CAT(poolfree, n)
+#endif /* shared heap --> */
+
+#ifdef POOL_FREE_LIST /* <!-- list */
+/* The link is stored in the removed item; it must fit. */
+typedef char PP_(free_list_fits)[sizeof(PP_(type)) >= sizeof(size_t) ? 1 : -1];
+/* Stack of `size` removed indices in slab-zero, starting at `head`. */
+struct PP_(free_list) { size_t head, size; };
+#endif /* list --> */
 
 /** This is a slab memory-manager and free-heap for slab zero. A zeroed pool is
  a valid state. To instantiate to an idle state, see <fn:<P>pool>, `{0}`
@@ -104,10 +617,858 @@ struct PP_(slot) { size_t size; PP_(type) *slab; };
  ![States.](../doc/states.png) */
 struct P_(pool) {
 	struct PP_(slot_array) slots;
-	struct poolfree_heap free0; /* Free-heap in slab-zero. */
+#if defined(POOL_FREE_LIST) /* <!-- list */
+	struct PP_(free_list) free0; /* Free-list in slab-zero. */
+#elif defined(POOL_FREE_BITMAP) /* list --><!-- bitmap */
+	struct pool_bitmap free0; /* Free-bitmap in slab-zero. */
+#else /* bitmap --><!-- heap */
+	struct PF_(heap) free0; /* Free-heap in slab-zero. */
+#endif /* heap --> */
 	size_t capacity0; /* Capacity of slab-zero. */
+	size_t size, capacity; /* Items, and the capacity of all the slabs. */
+	size_t peak_size, peak_bytes; /* Watermarks. */
+#ifdef POOL_RADIX /* <!-- radix */
+	size_t ***radix; /* Granule to slot index. */
+#endif /* radix --> */
+#ifdef POOL_ALLOCATOR /* <!-- allocator */
+	void *context; /* Passed to the allocator. */
+#endif /* allocator --> */
+#ifdef POOL_COLOUR /* <!-- colour */
+	size_t colour; /* Slabs allocated, to rotate the colour. */
+#endif /* colour --> */
+#ifdef POOL_RETAIN /* <!-- retain */
+	struct PP_(retained) retained[POOL_RETAIN]; /* Oldest first. */
+	size_t retained_size, retained_bytes, epoch; /* Epoch of slab events. */
+#endif /* retain --> */
+#ifdef POOL_PAGE_FREE /* <!-- page */
+	size_t *page_live, page_capacity; /* Live items on pages of slab-zero. */
+#endif /* page --> */
+#ifdef POOL_LIMIT /* <!-- limit */
+	size_t limit; /* Bytes, or zero for none. */
+	PP_(reclaim_fn) reclaim;
+	void *reclaim_param;
+#endif /* limit --> */
+#ifdef POOL_TRACE /* <!-- trace */
+	struct pool_trace *trace; /* Null if not recording. */
+#endif /* trace --> */
+#ifdef POOL_SAMPLE /* <!-- sample */
+	struct pool_sample *sample; /* Null if not sampling. */
+#endif /* sample --> */
 };
 
+/** A snapshot of a pool from <fn:<P>pool_stats>. The capacity of each
+ secondary slab is in the slots, but only the total is kept. */
+struct P_(pool_stats) {
+	size_t size, capacity, capacity0, slabs; /* Items in all the slabs. */
+	size_t free0, free0_bytes; /* Removed in slab-zero, and it's memory. */
+	size_t metadata, bytes; /* Slots, free-heap, and pages; all together. */
+	size_t peak_size, peak_bytes; /* Watermarks. */
+	double fragmentation; /* Free space, not the tail, over the capacity. */
+#ifdef POOL_COLOUR /* <!-- colour */
+	size_t base_colour, next_colour; /* Of the first slab, and the next. */
+#endif /* colour --> */
+};
+
+#ifdef POOL_ALLOCATOR /* <!-- allocator */
+/** @return `size` bytes from the allocator of `pool`. */
+static void *PP_(malloc)(const struct P_(pool) *const pool, const size_t size)
+	{ return PP_(alloc_hook)(pool->context, size); }
+/** @return `data` resized to `size` bytes by the allocator of `pool`. */
+static void *PP_(realloc)(const struct P_(pool) *const pool,
+	void *const data, const size_t size)
+	{ return PP_(realloc_hook)(pool->context, data, size); }
+/** Frees `data` with the allocator of `pool`. */
+static void PP_(free)(const struct P_(pool) *const pool, void *const data)
+	{ PP_(free_hook)(pool->context, data); }
+/** @return `n` zeroed elements of `size` from the allocator of `pool`. */
+static void *PP_(calloc)(const struct P_(pool) *const pool, const size_t n,
+	const size_t size) {
+	void *data;
+	if(size && n > (size_t)-1 / size) return errno = ERANGE, (void *)0;
+	if((data = PP_(malloc)(pool, n * size))) memset(data, 0, n * size);
+	return data;
+}
+#ifndef POOL_INLINE_SLOTS /* <!-- array */
+/** @return The pool that has `slots`. */
+static const struct P_(pool) *PP_(slots_pool)(const void *const slots)
+	{ return (const struct P_(pool) *)(const void *)((const char *)slots
+	- offsetof(struct P_(pool), slots)); }
+/** Reallocates `data` of the slots array, `slots`. */
+static void *PP_(slots_realloc)(const void *const slots, void *const data,
+	const size_t size)
+	{ return PP_(realloc)(PP_(slots_pool)(slots), data, size); }
+/** Frees `data` of the slots array, `slots`. */
+static void PP_(slots_free)(const void *const slots, void *const data)
+	{ PP_(free)(PP_(slots_pool)(slots), data); }
+#endif /* array --> */
+#ifndef POOL_FREE_CONSTANT /* <!-- heap */
+/** @return The pool that has the array of the free-heap, `heap`. */
+static const struct P_(pool) *PP_(heap_pool)(const void *const heap)
+	{ return (const struct P_(pool) *)(const void *)((const char *)heap
+	- offsetof(struct P_(pool), free0)); }
+/** Reallocates `data` of the free-heap array, `heap`. */
+static void *PP_(heap_realloc)(const void *const heap, void *const data,
+	const size_t size)
+	{ return PP_(realloc)(PP_(heap_pool)(heap), data, size); }
+/** Frees `data` of the free-heap array, `heap`. */
+static void PP_(heap_free)(const void *const heap, void *const data)
+	{ PP_(free)(PP_(heap_pool)(heap), data); }
+#endif /* heap --> */
+#else /* allocator --><!-- stdlib */
+/** @return `size` bytes from `malloc`. */
+static void *PP_(malloc)(const struct P_(pool) *const pool, const size_t size)
+	{ return (void)pool, malloc(size); }
+/** @return `data` resized to `size` bytes by `realloc`. */
+static void *PP_(realloc)(const struct P_(pool) *const pool,
+	void *const data, const size_t size)
+	{ return (void)pool, realloc(data, size); }
+/** Frees `data` with `free`. */
+static void PP_(free)(const struct P_(pool) *const pool, void *const data)
+	{ (void)pool, free(data); }
+/** @return `n` zeroed elements of `size` from `calloc`. */
+static void *PP_(calloc)(const struct P_(pool) *const pool, const size_t n,
+	const size_t size) { return (void)pool, calloc(n, size); }
+#endif /* stdlib --> */
+
+/* Whatever grows the metadata raises the watermark. */
+static void PP_(peak_bytes)(struct P_(pool) *);
+
+/* The free-heap, free-list, or free-bitmap of slab-zero is abstracted.
+ `pop_if` is used to shrink the tail over removed items. */
+#if defined(POOL_FREE_LIST) /* <!-- list */
+/** @return How many removed in slab-zero of `pool`. */
+static size_t PP_(free0_size)(const struct P_(pool) *const pool)
+	{ return pool->free0.size; }
+/** Pops the head of the free-list in `pool`. @return The index. */
+static size_t PP_(free0_take)(struct P_(pool) *const pool) {
+	const size_t idx = pool->free0.head;
+	assert(pool->free0.size);
+	if(--pool->free0.size) memcpy(&pool->free0.head,
+		PP_(at)(pool->slots.data[0].slab, idx), sizeof pool->free0.head);
+	return idx;
+}
+/** If the head of the free-list in `pool` is `idx`, pops it.
+ @return Whether it was popped. */
+static int PP_(free0_pop_if)(struct P_(pool) *const pool, const size_t idx) {
+	if(!pool->free0.size || pool->free0.head != idx) return 0;
+	PP_(free0_take)(pool);
+	return 1;
+}
+/** Pushes `idx` on the free-list of `pool`. @return True. @order \Theta(1) */
+static int PP_(free0_add)(struct P_(pool) *const pool, const size_t idx) {
+	if(pool->free0.size) memcpy(PP_(at)(pool->slots.data[0].slab, idx),
+		&pool->free0.head, sizeof pool->free0.head);
+	pool->free0.head = idx, pool->free0.size++;
+	return 1;
+}
+/** The free-list of `pool` takes no memory for capacity `c`. @return True. */
+static int PP_(free0_reserve)(struct P_(pool) *const pool, const size_t c)
+	{ return (void)pool, (void)c, 1; }
+/** Empties the free-list of `pool`. */
+static void PP_(free0_clear)(struct P_(pool) *const pool)
+	{ pool->free0.size = 0; }
+/** Destructor for the free-list of `pool`; it has no memory. */
+static void PP_(free0_)(struct P_(pool) *const pool)
+	{ pool->free0.head = pool->free0.size = 0; }
+/** @return The free-list of `pool` has no memory; zero. */
+static size_t PP_(free0_bytes)(const struct P_(pool) *const pool)
+	{ return (void)pool, 0; }
+/** The free-list of `pool` has no memory to give back. @return Zero. */
+static size_t PP_(free0_shrink)(struct P_(pool) *const pool, const size_t c)
+	{ return (void)pool, (void)c, 0; }
+#elif defined(POOL_FREE_BITMAP) /* list --><!-- bitmap */
+/** @return How many removed in slab-zero of `pool`. */
+static size_t PP_(free0_size)(const struct P_(pool) *const pool)
+	{ return pool->free0.size; }
+/** @return The summary words of `pool`, which come after the bitmap. */
+static unsigned long *PP_(free0_summary)(const struct P_(pool) *const pool)
+	{ return pool->free0.bits + pool_words(pool->capacity0); }
+/** @return Whether `idx` in slab-zero of `pool` is removed. */
+static int PP_(free0_is)(const struct P_(pool) *const pool, const size_t idx)
+	{ return assert(idx < pool->capacity0),
+	!!(pool->free0.bits[idx / POOL_WORD_BIT] & 1ul << idx % POOL_WORD_BIT); }
+/** Un-removes `idx` in `pool`, and the summary if the word becomes empty. */
+static void PP_(free0_unset)(struct P_(pool) *const pool, const size_t idx) {
+	const size_t w = idx / POOL_WORD_BIT;
+	assert(pool->free0.size && PP_(free0_is)(pool, idx));
+	pool->free0.size--;
+	if(pool->free0.bits[w] &= ~(1ul << idx % POOL_WORD_BIT)) return;
+	PP_(free0_summary)(pool)[w / POOL_WORD_BIT] &= ~(1ul << w % POOL_WORD_BIT);
+}
+/** Takes the lowest removed index in `pool`: a scan of the summary from the
+ hint, then `ctz` on the summary and on the word. @return The index. */
+static size_t PP_(free0_take)(struct P_(pool) *const pool) {
+	const unsigned long *const summary = PP_(free0_summary)(pool);
+	size_t s, w, idx;
+	assert(pool->free0.size);
+	s = pool->free0.hint = pool_nonzero(summary, pool->free0.hint,
+		pool_words(pool_words(pool->capacity0)));
+	w = s * POOL_WORD_BIT + pool_ctz(summary[s]);
+	idx = w * POOL_WORD_BIT + pool_ctz(pool->free0.bits[w]);
+	PP_(free0_unset)(pool, idx);
+	return idx;
+}
+/** If `idx` is removed in `pool`, it's not anymore.
+ @return Whether it was. @order \Theta(1) */
+static int PP_(free0_pop_if)(struct P_(pool) *const pool, const size_t idx) {
+	if(!PP_(free0_is)(pool, idx)) return 0;
+	PP_(free0_unset)(pool, idx);
+	return 1;
+}
+/** Sets `idx` as removed in `pool`. @return True. @order \Theta(1) */
+static int PP_(free0_add)(struct P_(pool) *const pool, const size_t idx) {
+	const size_t w = idx / POOL_WORD_BIT, s = w / POOL_WORD_BIT;
+	assert(!PP_(free0_is)(pool, idx));
+	if(!pool->free0.bits[w]) {
+		PP_(free0_summary)(pool)[s] |= 1ul << w % POOL_WORD_BIT;
+		if(s < pool->free0.hint) pool->free0.hint = s;
+	}
+	pool->free0.bits[w] |= 1ul << idx % POOL_WORD_BIT;
+	pool->free0.size++;
+	return 1;
+}
+/** Makes sure the bitmap of `pool` has room for a slab of capacity `c`.
+ @return Success. @throws[ERANGE, realloc] */
+static int PP_(free0_reserve)(struct P_(pool) *const pool, const size_t c) {
+	const size_t words = pool_words(c), total = words + pool_words(words);
+	unsigned long *bits;
+	if(pool->free0.bits && c <= pool->capacity0) return 1;
+	if(total > (size_t)-1 / sizeof *bits) return errno = ERANGE, 0;
+	if(!(bits = PP_(realloc)(pool, pool->free0.bits, sizeof *bits * total)))
+		{ if(!errno) errno = ERANGE; return 0; }
+	pool->free0.bits = bits;
+	return 1;
+}
+#ifdef POOL_RESERVE /* <!-- reserve */
+/** Lays out the bitmap of `pool`, reserved for capacity `c`, for `c` instead
+ of `capacity0`, keeping the removed items. @order \O(`c`) */
+static void PP_(free0_expand)(struct P_(pool) *const pool, const size_t c) {
+	const size_t w0 = pool_words(pool->capacity0), s0 = pool_words(w0),
+		w1 = pool_words(c), s1 = pool_words(w1);
+	unsigned long *const bits = pool->free0.bits;
+	assert(bits && pool->capacity0 <= c);
+	memmove(bits + w1, bits + w0, sizeof *bits * s0);
+	memset(bits + w0, 0, sizeof *bits * (w1 - w0));
+	memset(bits + w1 + s0, 0, sizeof *bits * (s1 - s0));
+}
+/** Lays out the bitmap of `pool` for `c` instead of `capacity0`, which is
+ more, keeping the removed items; they are all less than `c`. */
+static void PP_(free0_contract)(struct P_(pool) *const pool, const size_t c) {
+	const size_t w0 = pool_words(pool->capacity0), w1 = pool_words(c),
+		s1 = pool_words(w1);
+	unsigned long *const bits = pool->free0.bits;
+	assert(bits && c <= pool->capacity0);
+	memmove(bits + w1, bits + w0, sizeof *bits * s1);
+	pool->free0.hint = 0;
+}
+#endif /* reserve --> */
+/** Empties the free-bitmap of `pool`. @order \O(`capacity0`) */
+static void PP_(free0_clear)(struct P_(pool) *const pool) {
+	const size_t words = pool_words(pool->capacity0);
+	if(pool->free0.bits) memset(pool->free0.bits, 0,
+		sizeof *pool->free0.bits * (words + pool_words(words)));
+	pool->free0.size = pool->free0.hint = 0;
+}
+/** Destructor for the free-bitmap of `pool`. */
+static void PP_(free0_)(struct P_(pool) *const pool) {
+	PP_(free)(pool, pool->free0.bits);
+	pool->free0.bits = 0, pool->free0.size = pool->free0.hint = 0;
+}
+/** @return The bytes of the bitmap of `pool`. */
+static size_t PP_(free0_bytes)(const struct P_(pool) *const pool) {
+	const size_t words = pool_words(pool->capacity0);
+	return pool->free0.bits
+		? sizeof *pool->free0.bits * (words + pool_words(words)) : 0;
+}
+/** Fits the bitmap of `pool`, laid out for `capacity0`, that was for capacity
+ `c`. @return The bytes given back. */
+static size_t PP_(free0_shrink)(struct P_(pool) *const pool, const size_t c) {
+	const size_t w0 = pool_words(c), total0 = w0 + pool_words(w0),
+		w1 = pool_words(pool->capacity0), total1 = w1 + pool_words(w1);
+	unsigned long *bits;
+	if(!pool->free0.bits || total1 >= total0) return 0;
+	if(!total1) { PP_(free0_)(pool); return sizeof *bits * total0; }
+	if(!(bits = PP_(realloc)(pool, pool->free0.bits, sizeof *bits * total1)))
+		return 0;
+	pool->free0.bits = bits;
+	return sizeof *bits * (total0 - total1);
+}
+#else /* bitmap --><!-- heap */
+/** @return How many removed in slab-zero of `pool`. */
+static size_t PP_(free0_size)(const struct P_(pool) *const pool)
+	{ return pool->free0._.size; }
+/** Cheating: we prefer the minimum index from a max-heap, but it doesn't
+ really matter, so take the one off the array used for heap in `pool`.
+ @return The index. */
+static size_t PP_(free0_take)(struct P_(pool) *const pool)
+	{ return assert(pool->free0._.size),
+	pool->free0._.data[--pool->free0._.size]; }
+/** If the maximum of the free-heap in `pool` is `idx`, pops it.
+ @return Whether it was popped. @order \O(\log `free0`) */
+static int PP_(free0_pop_if)(struct P_(pool) *const pool, const size_t idx) {
+	const size_t *const top = PF_(heap_peek)(&pool->free0);
+	if(!top || *top != idx) return assert(!top || *top < idx), 0;
+	PF_(heap_pop)(&pool->free0);
+	return 1;
+}
+/** Adds `idx` to the free-heap of `pool`. @return Success. @throws[realloc] */
+static int PP_(free0_add)(struct P_(pool) *const pool, const size_t idx) {
+	const size_t capacity = pool->free0._.capacity;
+	if(!PF_(heap_add)(&pool->free0, idx)) return 0;
+	if(pool->free0._.capacity != capacity) {
+		POOL_PROBE(free0_grow, pool->free0._.size, pool->free0._.capacity);
+		PP_(peak_bytes)(pool);
+	}
+	return 1;
+}
+/** The free-heap of `pool` grows as needed, not with capacity `c`.
+ @return True. */
+static int PP_(free0_reserve)(struct P_(pool) *const pool, const size_t c)
+	{ return (void)pool, (void)c, 1; }
+/** Empties the free-heap of `pool`. */
+static void PP_(free0_clear)(struct P_(pool) *const pool)
+	{ PF_(heap_clear)(&pool->free0); }
+/** Destructor for the free-heap of `pool`. */
+static void PP_(free0_)(struct P_(pool) *const pool)
+	{ PF_(heap_)(&pool->free0); }
+/** @return The bytes of the free-heap of `pool`. */
+static size_t PP_(free0_bytes)(const struct P_(pool) *const pool)
+	{ return sizeof *pool->free0._.data * pool->free0._.capacity; }
+/** Fits the free-heap of `pool` to it's size; `c` is not used.
+ @return The bytes given back. */
+static size_t PP_(free0_shrink)(struct P_(pool) *const pool, const size_t c) {
+	const size_t capacity = pool->free0._.capacity;
+	(void)c;
+	if(!pool->free0._.size)
+		{ PP_(free0_)(pool); return sizeof *pool->free0._.data * capacity; }
+	if(!POOL_CAT(POOL_CAT(heap, PF_(node)), array_shrink)(&pool->free0._)
+		|| pool->free0._.capacity >= capacity) return 0;
+	return sizeof *pool->free0._.data * (capacity - pool->free0._.capacity);
+}
+#endif /* heap --> */
+
+#ifdef POOL_RADIX /* <!-- radix */
+/** @return The header just before aligned `slab`. */
+static struct pool_radix_head *PP_(radix_head)(const PP_(type) *const slab)
+	{ return (struct pool_radix_head *)(void *)slab - 1; }
+/** @return The granule of the radix table which contains `x`. */
+static size_t PP_(granule)(const void *const x)
+	{ return (size_t)(POOL_ADDRESS(x) >> POOL_RADIX); }
+/** @return The last granule of `slab` with `capacity`. */
+static size_t PP_(granule_last)(const PP_(type) *const slab,
+	const size_t capacity)
+	{ return PP_(granule)((const char *)PP_(at)(slab, capacity) - 1); }
+/** @return The entry of the radix table in `pool` that has granule `g`; the
+ leaf must exist. */
+static size_t *PP_(radix_at)(const struct P_(pool) *const pool,
+	const size_t g) {
+	return assert(pool->radix && pool->radix[g >> POOL_RADIX_SHIFT]
+		&& pool->radix[g >> POOL_RADIX_SHIFT][g >> POOL_RADIX_LEAF
+		& POOL_RADIX_MASK(POOL_RADIX_MID)]),
+		pool->radix[g >> POOL_RADIX_SHIFT][g >> POOL_RADIX_LEAF
+		& POOL_RADIX_MASK(POOL_RADIX_MID)] + (g
+		& POOL_RADIX_MASK(POOL_RADIX_LEAF));
+}
+/** Allocates a slab of `capacity` in `pool` aligned to a granule, with a
+ header before it; the slack is up to the granule size.
+ @return The slab or null. @throws[ERANGE, malloc] */
+static PP_(type) *PP_(slab_alloc)(const struct P_(pool) *const pool,
+	const size_t capacity) {
+	const size_t granule = (size_t)1 << POOL_RADIX,
+		extra = sizeof(struct pool_radix_head) + granule - 1;
+	char *raw;
+	size_t skip;
+	struct pool_radix_head *head;
+	if(capacity > ((size_t)-1 - extra) / POOL_STRIDE)
+		return errno = ERANGE, (PP_(type) *)0;
+	if(!(raw = PP_(malloc)(pool, capacity * POOL_STRIDE + extra)))
+		{ if(!errno) errno = ERANGE; return 0; }
+	skip = (granule - (size_t)((POOL_ADDRESS(raw)
+		+ sizeof(struct pool_radix_head)) & (granule - 1))) & (granule - 1);
+	head = (struct pool_radix_head *)(void *)(raw + skip);
+	head->raw = raw, head->capacity = capacity;
+	/* The table doesn't cover the higher addresses. */
+	if(POOL_ADDRESS(raw + capacity * POOL_STRIDE + extra - 1)
+		>> (POOL_ADDRESS_BITS - 1) >> 1)
+		{ PP_(free)(pool, raw); errno = ERANGE; return 0; }
+	return (PP_(type) *)(void *)(head + 1);
+}
+/** Frees `slab` from <fn:<PP>slab_alloc> in `pool`. */
+static void PP_(slab_free)(const struct P_(pool) *const pool,
+	PP_(type) *const slab)
+	{ if(slab) PP_(free)(pool, PP_(radix_head)(slab)->raw); }
+/** @return The capacity of `slab`. */
+static size_t PP_(slab_capacity)(const PP_(type) *const slab)
+	{ return PP_(radix_head)(slab)->capacity; }
+/** Makes sure there are leaves of the radix table in `pool` for all of
+ `slab`. @return Success; on failure, it may leave empty leaves.
+ @throws[malloc] */
+static int PP_(slot_map_reserve)(struct P_(pool) *const pool,
+	const PP_(type) *const slab) {
+	size_t g = PP_(granule)(slab), g1
+		= PP_(granule_last)(slab, PP_(radix_head)(slab)->capacity);
+	if(!pool->radix && !(pool->radix = PP_(calloc)(pool,
+		(size_t)1 << POOL_RADIX_ROOT,
+		sizeof *pool->radix))) goto catch;
+	for( ; g <= g1; g = (g | POOL_RADIX_MASK(POOL_RADIX_LEAF)) + 1) {
+		size_t ***const mid = pool->radix + (g >> POOL_RADIX_SHIFT), **leaf;
+		if(!*mid && !(*mid = PP_(calloc)(pool, (size_t)1 << POOL_RADIX_MID,
+			sizeof **mid))) goto catch;
+		leaf = *mid + (g >> POOL_RADIX_LEAF & POOL_RADIX_MASK(POOL_RADIX_MID));
+		if(!*leaf && !(*leaf = PP_(calloc)(pool, (size_t)1 << POOL_RADIX_LEAF,
+			sizeof **leaf))) goto catch;
+	}
+	return 1;
+catch:
+	if(!errno) errno = ERANGE;
+	return 0;
+}
+/** Points every granule of slots `[i, i_end)` of `pool` to it's slot. Slot
+ indices shift when the slots change, so this is \O(`granules`). */
+static void PP_(slot_map)(struct P_(pool) *const pool, size_t i,
+	const size_t i_end) {
+	assert(pool && i_end <= pool->slots.size);
+	for( ; i < i_end; i++) {
+		const PP_(type) *const slab = pool->slots.data[i].slab;
+		size_t g = PP_(granule)(slab),
+			g1 = PP_(granule_last)(slab, PP_(slab_capacity)(slab));
+		for( ; g <= g1; g++) *PP_(radix_at)(pool, g) = i;
+	}
+}
+/** Destructor for the radix table of `pool`. */
+static void PP_(radix_)(struct P_(pool) *const pool) {
+	size_t r, m;
+	if(!pool->radix) return;
+	for(r = 0; r < (size_t)1 << POOL_RADIX_ROOT; r++) {
+		if(!pool->radix[r]) continue;
+		for(m = 0; m < (size_t)1 << POOL_RADIX_MID; m++)
+			PP_(free)(pool, pool->radix[r][m]);
+		PP_(free)(pool, pool->radix[r]);
+	}
+	PP_(free)(pool, pool->radix), pool->radix = 0;
+}
+#elif defined(POOL_BLOCK) /* radix --><!-- block */
+/** @return The header at the start of the block that contains `x`. */
+static struct pool_block_head *PP_(block_head)(const void *const x)
+	{ return (struct pool_block_head *)(void *)((char *)(void *)x
+	- (size_t)(POOL_ADDRESS(x) & POOL_BLOCK_MASK)); }
+/** Allocates a slab of `capacity` in `pool` in a block aligned to its size,
+ after a header. @return The slab or null. @throws[malloc] */
+static PP_(type) *PP_(slab_alloc)(const struct P_(pool) *const pool,
+	const size_t capacity) {
+	const size_t block = POOL_BLOCK_MASK + 1;
+	char *raw;
+	struct pool_block_head *head;
+	assert(sizeof *head + capacity * POOL_STRIDE <= block);
+	if(!(raw = PP_(malloc)(pool, block + POOL_BLOCK_MASK)))
+		{ if(!errno) errno = ERANGE; return 0; }
+	head = (struct pool_block_head *)(void *)(raw + ((block
+		- (size_t)(POOL_ADDRESS(raw) & POOL_BLOCK_MASK)) & POOL_BLOCK_MASK));
+	head->raw = raw, head->capacity = capacity, head->slot = 0;
+	return (PP_(type) *)(void *)(head + 1);
+}
+/** Frees `slab` from <fn:<PP>slab_alloc> in `pool`. */
+static void PP_(slab_free)(const struct P_(pool) *const pool,
+	PP_(type) *const slab)
+	{ if(slab) PP_(free)(pool, PP_(block_head)(slab)->raw); }
+/** @return The capacity of `slab`. */
+static size_t PP_(slab_capacity)(const PP_(type) *const slab)
+	{ return PP_(block_head)(slab)->capacity; }
+/** The header is part of the block. @return True. */
+static int PP_(slot_map_reserve)(struct P_(pool) *const pool,
+	const PP_(type) *const slab) { return (void)pool, (void)slab, 1; }
+/** Points the headers of slots `[i, i_end)` of `pool` back to their slot.
+ @order \O(`i_end` - `i`) */
+static void PP_(slot_map)(struct P_(pool) *const pool, size_t i,
+	const size_t i_end) {
+	assert(pool && i_end <= pool->slots.size);
+	for( ; i < i_end; i++)
+		PP_(block_head)(pool->slots.data[i].slab)->slot = i;
+}
+#elif defined(POOL_HUGE) /* block --><!-- huge */
+/** @return The header at the start of the mapping of `slab`. */
+static struct pool_huge_head *PP_(huge_head)(const PP_(type) *const slab)
+	{ return (struct pool_huge_head *)(void *)slab - 1; }
+/** @return The bytes in whole huge pages of a slab of `capacity` and it's
+ header; `capacity` must be checked. */
+static size_t PP_(huge_bytes)(const size_t capacity)
+	{ return (sizeof(struct pool_huge_head) + capacity * POOL_STRIDE
+	+ POOL_HUGE_MASK) & ~POOL_HUGE_MASK; }
+/** @return The greatest `capacity` that fits in the same huge pages, or
+ `max`, whichever is less. */
+static size_t PP_(huge_capacity)(const size_t capacity, const size_t max) {
+	size_t c;
+	if(capacity > ((size_t)-1 - sizeof(struct pool_huge_head)
+		- 3 * POOL_HUGE_MASK) / POOL_STRIDE) return max;
+	c = (PP_(huge_bytes)(capacity) - sizeof(struct pool_huge_head))
+		/ POOL_STRIDE;
+	return c < max ? c : max;
+}
+/** Maps a slab of `capacity` in huge pages, with a header before it; `pool`
+ is not used. @return The slab or null. @throws[ERANGE, mmap] */
+static PP_(type) *PP_(slab_alloc)(const struct P_(pool) *const pool,
+	const size_t capacity) {
+	const size_t page = POOL_HUGE_MASK + 1;
+	size_t bytes, skip;
+	char *raw = MAP_FAILED;
+	struct pool_huge_head *head;
+	const int e = errno; /* The hints may fail harmlessly. */
+	(void)pool;
+	if(capacity > ((size_t)-1 - sizeof *head - 3 * POOL_HUGE_MASK)
+		/ POOL_STRIDE) return errno = ERANGE, (PP_(type) *)0;
+	bytes = PP_(huge_bytes)(capacity);
+#ifdef MAP_HUGETLB /* <!-- hugetlb: reserved, and aligned to the page. */
+	raw = mmap(0, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS
+#ifdef MAP_HUGE_SHIFT
+		| POOL_HUGE << MAP_HUGE_SHIFT
+#endif
+		| MAP_HUGETLB, -1, 0);
+#endif /* hugetlb --> */
+	if(raw == (char *)MAP_FAILED) {
+		/* Over-map by a page, and trim so it's in aligned huge pages. */
+		if((raw = mmap(0, bytes + page, PROT_READ | PROT_WRITE,
+			MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)) == (char *)MAP_FAILED)
+			{ if(!errno) errno = ERANGE; return 0; }
+		skip = (page - (size_t)(POOL_ADDRESS(raw) & POOL_HUGE_MASK))
+			& POOL_HUGE_MASK;
+		if(skip) munmap(raw, skip);
+		munmap(raw + skip + bytes, page - skip);
+		raw += skip;
+#ifdef MADV_HUGEPAGE
+		madvise(raw, bytes, MADV_HUGEPAGE);
+#endif
+	}
+	errno = e;
+	head = (struct pool_huge_head *)(void *)raw;
+	head->bytes = bytes, head->capacity = capacity;
+	return (PP_(type) *)(void *)(head + 1);
+}
+/** Unmaps `slab` from <fn:<PP>slab_alloc>; `pool` is not used. */
+static void PP_(slab_free)(const struct P_(pool) *const pool,
+	PP_(type) *const slab) {
+	struct pool_huge_head *head;
+	(void)pool;
+	if(!slab) return;
+	head = PP_(huge_head)(slab);
+	munmap((void *)head, head->bytes);
+}
+/** @return The capacity of `slab`. */
+static size_t PP_(slab_capacity)(const PP_(type) *const slab)
+	{ return PP_(huge_head)(slab)->capacity; }
+#elif defined(POOL_RESERVE) /* huge --><!-- reserve */
+/** Unmaps the reservation at `slab`; `pool` is not used. */
+static void PP_(slab_free)(const struct P_(pool) *const pool,
+	PP_(type) *const slab)
+	{ (void)pool; if(slab) munmap((void *)slab, (size_t)1 << POOL_RESERVE); }
+#elif defined(POOL_ALIGNMENT) || defined(POOL_COLOUR) /* reserve --><!-- head */
+#ifdef POOL_COLOUR /* <!-- colour */
+/* Before a coloured slab. */
+struct PP_(slab_head) { void *raw; size_t colour; };
+#define POOL_SLAB_ALIGN POOL_COLOUR_LINE
+#define POOL_SLAB_SLACK ((POOL_COLOUR - 1) * (size_t)POOL_COLOUR_LINE)
+/** @return The colour of the first slab of `pool`, from where it is, so
+ pools of the same type don't all start on the same line. */
+static size_t PP_(base_colour)(const struct P_(pool) *const pool)
+	{ return (size_t)(POOL_ADDRESS(pool) / sizeof *pool) % POOL_COLOUR; }
+/** @return The colour of the next slab of `pool`. */
+static size_t PP_(colour)(const struct P_(pool) *const pool)
+	{ return (PP_(base_colour)(pool) + pool->colour) % POOL_COLOUR; }
+#else /* colour --><!-- !colour */
+/* Before an aligned slab. */
+struct PP_(slab_head) { void *raw; };
+#define POOL_SLAB_ALIGN POOL_ALIGNMENT
+#define POOL_SLAB_SLACK 0
+#endif /* !colour --> */
+/** Allocates a slab of `capacity` in `pool` aligned to `POOL_SLAB_ALIGN`, and
+ coloured, with the <tag:<PP>slab_head> just before it. @return The slab or
+ null. @throws[ERANGE, malloc] */
+static PP_(type) *PP_(slab_alloc)(const struct P_(pool) *const pool,
+	const size_t capacity) {
+	const size_t extra = sizeof(struct PP_(slab_head)) + POOL_SLAB_ALIGN - 1
+		+ POOL_SLAB_SLACK;
+	struct PP_(slab_head) head;
+	char *slab;
+	if(capacity > ((size_t)-1 - extra) / POOL_STRIDE)
+		return errno = ERANGE, (PP_(type) *)0;
+	if(!(head.raw = PP_(malloc)(pool, capacity * POOL_STRIDE + extra)))
+		{ if(!errno) errno = ERANGE; return 0; }
+	slab = (char *)head.raw + sizeof head + ((POOL_SLAB_ALIGN
+		- (size_t)((POOL_ADDRESS(head.raw) + sizeof head)
+		& (POOL_SLAB_ALIGN - 1))) & (POOL_SLAB_ALIGN - 1));
+#ifdef POOL_COLOUR
+	head.colour = PP_(colour)(pool);
+	slab += head.colour * POOL_COLOUR_LINE;
+#endif
+	memcpy(slab - sizeof head, &head, sizeof head);
+	return (PP_(type) *)(void *)slab;
+}
+/** @return The <tag:<PP>slab_head> of `slab`. */
+static struct PP_(slab_head) PP_(slab_head)(const PP_(type) *const slab) {
+	struct PP_(slab_head) head;
+	memcpy(&head, (const char *)(const void *)slab - sizeof head, sizeof head);
+	return head;
+}
+/** Frees `slab` from <fn:<PP>slab_alloc> in `pool`. */
+static void PP_(slab_free)(const struct P_(pool) *const pool,
+	PP_(type) *const slab)
+	{ if(slab) PP_(free)(pool, PP_(slab_head)(slab).raw); }
+#else /* head --><!-- plain */
+/** Frees `slab` in `pool`. */
+static void PP_(slab_free)(const struct P_(pool) *const pool,
+	PP_(type) *const slab) { PP_(free)(pool, slab); }
+#endif /* plain --> */
+
+#ifdef POOL_RETAIN /* <!-- retain */
+/** Frees the oldest retained slab of `pool`. */
+static void PP_(retained_shift)(struct P_(pool) *const pool) {
+	struct PP_(retained) *const r = pool->retained;
+	assert(pool->retained_size);
+	pool->retained_bytes -= r->capacity * POOL_STRIDE;
+	PP_(slab_free)(pool, r->slab);
+	memmove(r, r + 1, sizeof *r * --pool->retained_size);
+}
+/** Counts a slab event in `pool`, and frees the retained slabs that have not
+ been used in `POOL_RETAIN_DECAY` of them. */
+static void PP_(decay)(struct P_(pool) *const pool) {
+	pool->epoch++;
+	while(pool->retained_size
+		&& pool->epoch - pool->retained[0].epoch > POOL_RETAIN_DECAY)
+		PP_(retained_shift)(pool);
+}
+/** The empty slab of `slot` in `pool` is retained, if it can be, making room
+ by freeing the oldest; otherwise it's freed. */
+static void PP_(release)(struct P_(pool) *const pool,
+	const struct PP_(slot) *const slot) {
+	const size_t bytes = slot->capacity * POOL_STRIDE;
+	struct PP_(retained) *r;
+	assert(slot->slab && slot->capacity && slot->capacity <= pool->capacity);
+	POOL_COUNT(release, 1);
+	POOL_PROBE(slab_free, slot->capacity, pool->slots.size - 1);
+	pool->capacity -= slot->capacity;
+	PP_(decay)(pool);
+	if(bytes > POOL_RETAIN_BYTES) { PP_(slab_free)(pool, slot->slab); return; }
+	while(pool->retained_size == POOL_RETAIN
+		|| bytes > POOL_RETAIN_BYTES - pool->retained_bytes)
+		PP_(retained_shift)(pool);
+	r = pool->retained + pool->retained_size++;
+	r->slab = slot->slab, r->capacity = slot->capacity, r->epoch = pool->epoch;
+	pool->retained_bytes += bytes;
+}
+/** @return The retained slab in `pool` with the most capacity, if it has at
+ least `n`, otherwise null. */
+static struct PP_(retained) *PP_(retained)(struct P_(pool) *const pool,
+	const size_t n) {
+	struct PP_(retained) *r, *r_end, *most = 0;
+	for(r = pool->retained, r_end = r + pool->retained_size; r < r_end; r++)
+		if(r->capacity >= n && (!most || r->capacity > most->capacity))
+		most = r;
+	return most;
+}
+/** Takes `r` out of the retained slabs of `pool`. @return It's slab. */
+static PP_(type) *PP_(unretain)(struct P_(pool) *const pool,
+	struct PP_(retained) *const r) {
+	PP_(type) *const slab = r->slab;
+	assert(pool->retained <= r && r < pool->retained + pool->retained_size);
+	pool->retained_bytes -= r->capacity * POOL_STRIDE;
+	memmove(r, r + 1, sizeof *r
+		* (size_t)(pool->retained + --pool->retained_size - r));
+	return slab;
+}
+#else /* retain --><!-- free */
+/** Frees the empty slab of `slot` in `pool`. */
+static void PP_(release)(struct P_(pool) *const pool,
+	const struct PP_(slot) *const slot) {
+	assert(slot->capacity <= pool->capacity);
+	POOL_COUNT(release, 1);
+	POOL_PROBE(slab_free, slot->capacity, pool->slots.size - 1);
+	pool->capacity -= slot->capacity;
+	PP_(slab_free)(pool, slot->slab);
+}
+#endif /* free --> */
+
+#ifdef POOL_PAGE_FREE /* <!-- page */
+/** @return The most pages that a slab of capacity `c` touches. */
+static size_t PP_(pages)(const size_t c)
+	{ return c * POOL_STRIDE / POOL_PAGE + 2; }
+/** @return The offset of slab zero of `pool` in it's first page. */
+static size_t PP_(page_offset)(const struct P_(pool) *const pool) {
+	return (size_t)(POOL_ADDRESS(pool->slots.data[0].slab)
+		& (POOL_PAGE - 1));
+}
+/** Makes sure `pool` has a count for every page of slab zero with capacity
+ `c`. @return Success. @throws[ERANGE, realloc] */
+static int PP_(pages_reserve)(struct P_(pool) *const pool, const size_t c) {
+	const size_t pages = PP_(pages)(c);
+	size_t *live;
+	if(pages <= pool->page_capacity) return 1;
+	if(pages > (size_t)-1 / sizeof *live) return errno = ERANGE, 0;
+	if(!(live = PP_(realloc)(pool, pool->page_live, sizeof *live * pages)))
+		{ if(!errno) errno = ERANGE; return 0; }
+	memset(live + pool->page_capacity, 0,
+		sizeof *live * (pages - pool->page_capacity));
+	pool->page_live = live, pool->page_capacity = pages;
+	PP_(peak_bytes)(pool);
+	return 1;
+}
+/** Counts `n` items from `idx` in slab zero of `pool` on every page they
+ touch. @order \O(pages) */
+static void PP_(pages_new)(struct P_(pool) *const pool, const size_t idx,
+	const size_t n) {
+	const size_t o = PP_(page_offset)(pool), end = idx + n,
+		p_end = ((o + end * POOL_STRIDE - 1) >> POOL_PAGE_FREE) + 1;
+	size_t p = (o + idx * POOL_STRIDE) >> POOL_PAGE_FREE, lo, hi;
+	assert(n && end <= pool->capacity0 && p_end <= pool->page_capacity);
+	for( ; p < p_end; p++) {
+		/* The items of the run that overlap the page. */
+		lo = p << POOL_PAGE_FREE, lo = lo > o ? (lo - o) / POOL_STRIDE : 0;
+		hi = (((p + 1) << POOL_PAGE_FREE) - o + POOL_STRIDE - 1) / POOL_STRIDE;
+		if(lo < idx) lo = idx;
+		if(hi > end) hi = end;
+		assert(lo < hi);
+		pool->page_live[p] += hi - lo;
+	}
+}
+/** Advises the system that `bytes` at `page` are not needed; they come back
+ as they were, or zeroed. It's only advice, so errors are ignored. */
+static void PP_(pages_free)(char *const page, const size_t bytes) {
+	const int e = errno;
+	if(!bytes) return;
+#ifdef MADV_FREE
+	if(!madvise(page, bytes, MADV_FREE)) { errno = e; return; }
+#endif
+	madvise(page, bytes, MADV_DONTNEED);
+	errno = e;
+}
+/** Un-counts `idx` in slab zero of `pool`; the pages that are left with no
+ items and are wholly in the slab are given back. */
+static void PP_(pages_remove)(struct P_(pool) *const pool, const size_t idx) {
+	const size_t o = PP_(page_offset)(pool),
+		end = o + pool->capacity0 * POOL_STRIDE,
+		p_end = ((o + (idx + 1) * POOL_STRIDE - 1) >> POOL_PAGE_FREE) + 1;
+	char *const base = (char *)(void *)pool->slots.data[0].slab - o;
+	size_t p = (o + idx * POOL_STRIDE) >> POOL_PAGE_FREE;
+	assert(idx < pool->capacity0 && p_end <= pool->page_capacity);
+	for( ; p < p_end; p++) {
+		assert(pool->page_live[p]);
+		if(--pool->page_live[p] || (p << POOL_PAGE_FREE) < o
+			|| ((p + 1) << POOL_PAGE_FREE) > end) continue;
+		PP_(pages_free)(base + (p << POOL_PAGE_FREE), POOL_PAGE);
+	}
+}
+/** Zeroes the counts of `pool`. If `is_kept`, slab zero is staying, and the
+ pages of it up to the tail that are wholly in it are given back. */
+static void PP_(pages_clear)(struct P_(pool) *const pool, const int is_kept) {
+	size_t o, begin, end, tail;
+	if(pool->page_live) memset(pool->page_live, 0,
+		sizeof *pool->page_live * pool->page_capacity);
+	if(!is_kept || !pool->slots.size) return;
+	o = PP_(page_offset)(pool), begin = o ? POOL_PAGE : 0;
+	end = (o + pool->capacity0 * POOL_STRIDE) & ~(POOL_PAGE - 1);
+	tail = (o + pool->slots.data[0].size * POOL_STRIDE + POOL_PAGE - 1)
+		& ~(POOL_PAGE - 1);
+	if(tail < end) end = tail;
+	if(begin < end) PP_(pages_free)((char *)(void *)pool->slots.data[0].slab
+		- o + begin, end - begin);
+}
+/** Fits the counts of `pool` to slab zero. @return The bytes given back. */
+static size_t PP_(pages_shrink)(struct P_(pool) *const pool) {
+	const size_t capacity = pool->page_capacity,
+		pages = pool->slots.size ? PP_(pages)(pool->capacity0) : 0;
+	size_t *live;
+	if(pages >= capacity) return 0;
+	if(!pages) {
+		PP_(free)(pool, pool->page_live);
+		pool->page_live = 0, pool->page_capacity = 0;
+	} else {
+		if(!(live = PP_(realloc)(pool, pool->page_live, sizeof *live * pages)))
+			return 0;
+		pool->page_live = live, pool->page_capacity = pages;
+	}
+	return sizeof *live * (capacity - pages);
+}
+#endif /* page --> */
+
+/** @return The bytes that `pool` has besides the slabs: the slots, the
+ free-heap, and the counts of pages. */
+static size_t PP_(metadata)(const struct P_(pool) *const pool) {
+	size_t bytes = PP_(free0_bytes)(pool);
+#ifndef POOL_INLINE_SLOTS
+	bytes += sizeof *pool->slots.data * pool->slots.capacity;
+#endif
+#ifdef POOL_PAGE_FREE
+	bytes += sizeof *pool->page_live * pool->page_capacity;
+#endif
+	return bytes;
+}
+/** @return The bytes that `pool` has: the items of every slab, retained or
+ not, and the <fn:<PP>metadata>. */
+static size_t PP_(footprint)(const struct P_(pool) *const pool) {
+	size_t bytes = pool->capacity * POOL_STRIDE + PP_(metadata)(pool);
+#ifdef POOL_RETAIN
+	bytes += pool->retained_bytes;
+#endif
+	return bytes;
+}
+/** Raises the peak bytes of `pool` to what it has. */
+static void PP_(peak_bytes)(struct P_(pool) *const pool) {
+	const size_t bytes = PP_(footprint)(pool);
+	if(bytes > pool->peak_bytes) pool->peak_bytes = bytes;
+}
+/** Counts `n` new items in `pool`. */
+static void PP_(count_new)(struct P_(pool) *const pool, const size_t n) {
+	pool->size += n;
+	if(pool->size > pool->peak_size) pool->peak_size = pool->size;
+}
+
+#ifdef POOL_TRACE /* <!-- trace */
+/** Records `op` on `n` of `ptrs`, or, if null, of the run at `run`, in the
+ trace of `pool`, if it has one. */
+static void PP_(trace)(const struct P_(pool) *const pool,
+	const enum pool_trace_op op, PP_(type) *const *const ptrs,
+	const PP_(type) *const run, const size_t n) {
+	size_t i;
+	if(!pool->trace) return;
+	if(op == POOL_TRACE_CLEAR) { pool_trace_event(pool->trace, op, 0); return; }
+	for(i = 0; i < n; i++) pool_trace_event(pool->trace, op,
+		ptrs ? (const void *)ptrs[i] : (const void *)(run + i));
+}
+#endif /* trace --> */
+
+#ifdef POOL_SAMPLE /* <!-- sample */
+/** Counts down `n` new items of `ptrs`, or, if null, of the run at `run`,
+ in the sample of `pool`, if it has one, recording those that reach zero. */
+static void PP_(sample_new)(const struct P_(pool) *const pool,
+	PP_(type) *const *const ptrs, const PP_(type) *const run, const size_t n) {
+	struct pool_sample *const s = pool->sample;
+	size_t i = 0;
+	if(!s) return;
+	while(n - i >= s->countdown) i += s->countdown, pool_sample_record(s,
+		ptrs ? (const void *)ptrs[i - 1] : (const void *)PP_(at)(run, i - 1));
+	s->countdown -= n - i;
+}
+/** Takes `n` of `ptrs`, or, if null, of the run at `run`, out of the sample
+ of `pool`, if they were sampled. */
+static void PP_(sample_remove)(const struct P_(pool) *const pool,
+	PP_(type) *const *const ptrs, const PP_(type) *const run, const size_t n) {
+	struct pool_sample *const s = pool->sample;
+	size_t i;
+	if(!s || !s->live.size) return;
+	for(i = 0; i < n; i++) pool_sample_remove(s,
+		ptrs ? (const void *)ptrs[i] : (const void *)PP_(at)(run, i));
+}
+#endif /* sample --> */
+
+#ifdef POOL_LIMIT /* <!-- limit */
+/** @return The bytes that `pool` can add within it's limit, if it gave back
+ `freed` first. */
+static size_t PP_(limit_room)(const struct P_(pool) *const pool,
+	const size_t freed) {
+	const size_t bytes = PP_(footprint)(pool) - freed;
+	if(!pool->limit) return (size_t)-1;
+	return bytes < pool->limit ? pool->limit - bytes : 0;
+}
+#endif /* limit --> */
+
 #define BOX_CONTENT PP_(type_c) *
 /** Is `x` not null? @implements `is_content` */
 static int PP_(is_element_c)(PP_(type_c) *const x) { return !!x; }
@@ -115,7 +1476,7 @@ static int PP_(is_element_c)(PP_(type_c) *const x) { return !!x; }
  on `slot0` and ignores the free-heap. We don't have enough information to do
  otherwise, since (presumably) the memory address is in local variables and
  will be freed (hopefully.) Unreliable. */
-struct PP_(forward) { struct PP_(slot) *slot0; size_t i; };
+struct PP_(forward) { const struct PP_(slot) *slot0; size_t i; };
 /** @return Before `p`. @implements `forward` */
 static struct PP_(forward) PP_(forward)(const struct P_(pool) *const p)
 	{ struct PP_(forward) it; it.slot0 = p && p->slots.size
@@ -123,7 +1484,7 @@ static struct PP_(forward) PP_(forward)(const struct P_(pool) *const p)
 /** Move to next `it`. @return Element or null. @implements `next_c` */
 static PP_(type_c) *PP_(next_c)(struct PP_(forward) *const it)
 	{ return assert(it), it->slot0 && it->i < it->slot0->size
-	? it->slot0->slab + it->i++ : 0; }
+	? PP_(at)(it->slot0->slab, it->i++) : 0; }
 
 /* Box override information. */
 #define BOX_ PP_
@@ -136,11 +1497,13 @@ static size_t PP_(upper)(const struct PP_(slot_array) *const slots,
 	const struct PP_(slot) *const base = slots->data;
 	size_t n, b0, b1;
 	assert(slots && x);
+	POOL_COUNT(upper, 1);
 	if(!(n = slots->size)) return 0;
 	assert(base);
 	if(!--n) return 1;
 	/* The last one is a special case: it doesn't have an upper bound. */
 	for(b0 = 1, --n; n; n /= 2) {
+		POOL_COUNT(upper_depth, 1);
 		b1 = b0 + n / 2;
 		/* Cast to `void *` then `uintptr_t` if available. */
 		if(POOL_PTR x < POOL_PTR base[b1].slab)
@@ -153,6 +1516,72 @@ static size_t PP_(upper)(const struct PP_(slot_array) *const slots,
 	return b0 + ((const void *)x >= (const void *)base[slots->size - 1].slab);
 }
 
+#if defined(POOL_RADIX) /* <!-- radix */
+/** Which slot contains the slab that has `x` in `pool`? Mask and load.
+ @order \Theta(1) */
+static size_t PP_(slot_idx)(const struct P_(pool) *const pool,
+	const PP_(type) *const x) {
+	const size_t c = *PP_(radix_at)(pool, PP_(granule)(x));
+	return assert(pool && c < pool->slots.size
+		&& (const void *)x >= (const void *)pool->slots.data[c].slab), c;
+}
+#elif defined(POOL_BLOCK) /* radix --><!-- block */
+/** Which slot contains the slab that has `x` in `pool`? Rounds down to the
+ header. @order \Theta(1) */
+static size_t PP_(slot_idx)(const struct P_(pool) *const pool,
+	const PP_(type) *const x) {
+	const size_t c = PP_(block_head)(x)->slot;
+	return (void)pool, assert(pool && c < pool->slots.size
+		&& (const void *)x >= (const void *)pool->slots.data[c].slab), c;
+}
+#elif defined(POOL_RESERVE) /* block --><!-- reserve */
+/** There is only slab zero in `pool`, and `x` is in it. @return Zero.
+ @order \Theta(1) */
+static size_t PP_(slot_idx)(const struct P_(pool) *const pool,
+	const PP_(type) *const x) {
+	return (void)pool, (void)x, assert(pool && pool->slots.size == 1
+		&& (const void *)x >= (const void *)pool->slots.data[0].slab
+		&& (const void *)x < (const void *)PP_(at)(pool->slots.data[0].slab,
+		pool->capacity0)), 0;
+}
+#elif defined(POOL_INLINE_SLOTS) /* reserve --><!-- inline */
+/** Which slot contains the slab that has `x` in `pool`? Counts the secondary
+ slabs at or below `x`, without branching on the comparisons.
+ @order \O(`slots`) */
+static size_t PP_(slot_idx)(const struct P_(pool) *const pool,
+	const PP_(type) *const x) {
+	const struct PP_(slot) *const base = pool->slots.data;
+	const size_t size = pool->slots.size;
+	size_t i = 1, c = 0;
+	assert(pool && size && x);
+	if((const void *)x >= (const void *)base[0].slab
+		&& (const void *)x < (const void *)PP_(at)(base[0].slab, pool->capacity0))
+		return 0;
+#if defined(__AVX2__) && POOL_ADDRESS_MAX > 0xffffffff \
+	&& (defined(__GNUC__) || defined(__clang__))
+	{ /* The slabs of four slots gathered in a vector, compared signed. */
+		const pool_lane w = sizeof *base / sizeof(pool_lane),
+			o = offsetof(struct PP_(slot), slab) / sizeof(pool_lane);
+		const __m256i v = _mm256_set1_epi64x((pool_lane)POOL_ADDRESS(x)),
+			lane = _mm256_set_epi64x(3 * w + o, 2 * w + o, w + o, o);
+		assert(!(sizeof *base % sizeof(pool_lane))
+			&& !(offsetof(struct PP_(slot), slab) % sizeof(pool_lane))
+			&& !(POOL_ADDRESS(x) >> (POOL_ADDRESS_BITS - 1) >> 1));
+		for( ; i + 4 <= size; i += 4) {
+			const __m256i a = _mm256_i64gather_epi64((const pool_lane *)
+				(const void *)(base + i), lane, 8);
+			const int gt = _mm256_movemask_pd(_mm256_castsi256_pd(
+				_mm256_cmpgt_epi64(a, v)));
+			c += 4 - (size_t)__builtin_popcount((unsigned)gt);
+		}
+	}
+#endif
+	for( ; i < size; i++)
+		c += POOL_PTR base[i].slab <= POOL_PTR x;
+	return assert(c && c < size && (const void *)x
+		>= (const void *)base[c].slab), c;
+}
+#else /* inline --><!-- search */
 /** Which slot contains the slab that has `x` in `pool`?
  @order \O(\log `slots`), \O(\log \log `size`)? */
 static size_t PP_(slot_idx)(const struct P_(pool) *const pool,
@@ -163,54 +1592,210 @@ static size_t PP_(slot_idx)(const struct P_(pool) *const pool,
 	/* There's only one option. */
 	if(pool->slots.size <= 1
 		|| ((const void *)x >= (const void *)base[0].slab
-		&& (const void *)x < (const void *)(base[0].slab + pool->capacity0)))
+		&& (const void *)x < (const void *)PP_(at)(base[0].slab, pool->capacity0)))
 		return assert(pool->slots.size >= 1
 		&& (const void *)x >= (const void *)base[0].slab
-		&& (const void *)x < (const void *)(base[0].slab + pool->capacity0)), 0;
+		&& (const void *)x < (const void *)PP_(at)(base[0].slab, pool->capacity0)), 0;
 	up = PP_(upper)(&pool->slots, x);
 	return assert(up), up - 1;
 }
+#endif /* search --> */
 
-/** Makes sure there are space for `n` further items in `pool`.
- @return Success. */
-static int PP_(buffer)(struct P_(pool) *const pool, const size_t n) {
+#ifdef POOL_RESERVE /* <!-- reserve */
+/** Commits more of the reservation of slab zero in `pool`, reserving it the
+ first time, so there is room for `n` more items at the tail. The slab never
+ moves, and the removed items in it are kept.
+ @return Success. @throws[ERANGE, mmap, mprotect, malloc] */
+static int PP_(grow)(struct P_(pool) *const pool, const size_t n) {
+	const size_t page = (size_t)sysconf(_SC_PAGESIZE),
+		reserve = (size_t)1 << POOL_RESERVE,
+		max_size = reserve / POOL_STRIDE;
+	size_t c, c1, size0 = 0, committed, bytes;
+	struct PP_(slot) *slot;
+	char *slab;
+	assert(pool && page && !(page & (page - 1)) && page <= reserve);
+	if(pool->slots.size) size0 = pool->slots.data[0].size;
+	if(n > max_size - size0) return errno = ERANGE, 0;
+
+	/* Figure out the capacity, rounded up to fill the pages. */
+	c = pool->capacity0, c1 = c + (c >> 1) + (c >> 3); /* ~Golden ratio. */
+	c = (c1 < c || c1 > max_size) ? max_size : c1;
+	if(c < POOL_SLAB_MIN_CAPACITY) c = POOL_SLAB_MIN_CAPACITY;
+	if(c < size0 + n) c = size0 + n;
+	bytes = (c * POOL_STRIDE + page - 1) & ~(page - 1);
+#ifdef POOL_LIMIT
+	{ /* The pages that fit in the limit, counting the ones already there. */
+		const size_t room = PP_(limit_room)(pool, pool->capacity0 * POOL_STRIDE)
+			& ~(page - 1);
+		if(bytes > room) {
+			if(room / POOL_STRIDE < size0 + n)
+				return errno = POOL_LIMIT_ERRNO, 0;
+			bytes = room;
+		}
+	}
+#endif
+	c = bytes / POOL_STRIDE;
+	committed = (pool->capacity0 * POOL_STRIDE + page - 1) & ~(page - 1);
+
+	/* Everything that can fail is before any modification. */
+	if(!PP_(free0_reserve)(pool, c)) return 0;
+#ifdef POOL_PAGE_FREE
+	if(!PP_(pages_reserve)(pool, c)) return 0;
+#endif
+	if(pool->slots.size) {
+		slab = (char *)(void *)pool->slots.data[0].slab;
+	} else {
+		if(!PP_(slot_array_buffer)(&pool->slots, 1)) return 0;
+		PP_(peak_bytes)(pool);
+		if((slab = mmap(0, reserve, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS,
+			-1, 0)) == (char *)MAP_FAILED)
+			{ if(!errno) errno = ERANGE; return 0; }
+	}
+	if(bytes > committed && mprotect(slab + committed, bytes - committed,
+		PROT_READ | PROT_WRITE)) {
+		if(!pool->slots.size) munmap(slab, reserve);
+		if(!errno) errno = ERANGE;
+		return 0;
+	}
+	if(!pool->slots.size) {
+		slot = PP_(slot_array_insert)(&pool->slots, 1, 0);
+		slot->slab = (PP_(type) *)(void *)slab, slot->size = 0;
+	}
+#ifdef POOL_FREE_BITMAP
+	PP_(free0_expand)(pool, c);
+#endif
+	pool->slots.data[0].capacity = c;
+	POOL_PROBE(slab_new, c, pool->capacity0);
+	pool->capacity += c - pool->capacity0;
+	pool->capacity0 = c;
+	PP_(peak_bytes)(pool);
+	return 1;
+}
+#else /* reserve --><!-- slabs */
+/** Replaces slab zero of `pool` with a new, empty, slab of capacity at least
+ `n`. The old slab zero, if it has any items, is evicted to the sorted
+ secondary slabs, and the free-heap is spent, (they are counted as removed.)
+ @return Success. @throws[ERANGE, malloc] */
+static int PP_(grow)(struct P_(pool) *const pool, const size_t n) {
 	const size_t min_size = POOL_SLAB_MIN_CAPACITY,
-		max_size = (size_t)-1 / sizeof(PP_(type));
+#ifdef POOL_BLOCK
+		max_size = (POOL_BLOCK_MASK + 1 - sizeof(struct pool_block_head))
+		/ POOL_STRIDE;
+#else
+		max_size = (size_t)-1 / POOL_STRIDE;
+#endif
 	struct PP_(slot) *base = pool->slots.data, *slot;
 	PP_(type) *slab;
-	size_t c, insert;
+	size_t c, insert, live0 = 0;
 	int is_recycled = 0;
-	assert(pool && min_size <= max_size && pool->capacity0 <= max_size &&
-		(!pool->slots.size && !pool->free0._.size /* !slots[0] -> !free0 */
-		|| pool->slots.size && base
-		&& base[0].size <= pool->capacity0
-		&& (!pool->free0._.size
-		|| pool->free0._.size < base[0].size
-		&& pool->free0._.data[0] < base[0].size)));
-
-	/* Ensure space for new slot. */
-	if(!n || pool->slots.size && n <= pool->capacity0
-		- base[0].size + pool->free0._.size) return 1; /* Already enough. */
-	if(max_size < n) return errno = ERANGE, 1; /* Request unsatisfiable. */
+#ifdef POOL_RETAIN
+	struct PP_(retained) *retained;
+#endif
+	assert(pool && min_size <= max_size && pool->capacity0 <= max_size);
+	if(max_size < n) return errno = ERANGE, 0; /* Request unsatisfiable. */
 	if(!PP_(slot_array_buffer)(&pool->slots, 1)) return 0;
+	PP_(peak_bytes)(pool);
 	base = pool->slots.data; /* It may have moved! */
+	if(pool->slots.size) live0 = base[0].size - PP_(free0_size)(pool);
 
 	/* Figure out the capacity of the next slab. */
 	c = pool->capacity0;
-	if(pool->slots.size && base[0].size) { /* ~Golden ratio. */
+	if(live0) { /* ~Golden ratio. */
 		size_t c1 = c + (c >> 1) + (c >> 3);
 		c = (c1 < c || c1 > max_size) ? max_size : c1;
 	}
 	if(c < min_size) c = min_size;
 	if(c < n) c = n;
+#ifdef POOL_HUGE
+	c = PP_(huge_capacity)(c, max_size); /* Fill the pages. */
+#endif
+#ifdef POOL_RETAIN
+	/* Any retained slab that fits is cheaper than a new one. */
+	PP_(decay)(pool);
+#ifdef POOL_INLINE_SLOTS
+	/* A smaller slab zero breaks the geometric bound of the table; the other
+	 half of it is enough for growing geometrically. */
+	if(pool->slots.size >= POOL_SLOT_MAX / 2)
+		{ if((retained = PP_(retained)(pool, c))) c = retained->capacity; }
+	else
+#endif
+	if((retained = PP_(retained)(pool, n))) c = retained->capacity;
+#endif
+#ifdef POOL_LIMIT
+	/* Clamp to the limit; an empty slab zero is given back, and a retained
+	 slab is already counted. */
+#ifdef POOL_RETAIN
+	if(!retained)
+#endif
+	{
+		const size_t room = PP_(limit_room)(pool,
+			pool->slots.size && !live0 ? pool->capacity0 * POOL_STRIDE : 0);
+#ifdef POOL_HUGE
+		const size_t max = room >> POOL_HUGE ? (((room >> POOL_HUGE)
+			<< POOL_HUGE) - sizeof(struct pool_huge_head)) / POOL_STRIDE : 0;
+#else
+		const size_t max = room / POOL_STRIDE;
+#endif
+		if(c > max) {
+			if(n > max) return errno = POOL_LIMIT_ERRNO, 0;
+			c = max;
+		}
+	}
+#endif
 
 	/* Allocate it; check if the current one is empty. */
-	if(pool->slots.size && !base[0].size)
-		is_recycled = 1, slab = realloc(base[0].slab, c * sizeof *slab);
-	else slab = malloc(c * sizeof *slab);
+	if(!PP_(free0_reserve)(pool, c)) return 0;
+#ifdef POOL_PAGE_FREE
+	if(!PP_(pages_reserve)(pool, c)) return 0;
+#endif
+	/* Aligned slabs can't be reallocated. */
+#if defined(POOL_SLOT_MAP) || defined(POOL_HUGE) \
+	|| defined(POOL_ALIGNMENT) || defined(POOL_COLOUR) /* <!-- aligned */
+#ifdef POOL_RETAIN
+	if(retained) slab = PP_(unretain)(pool, retained); else
+#endif
+	if(!(slab = PP_(slab_alloc)(pool, c))) return 0;
+#ifdef POOL_COLOUR
+	pool->colour++;
+#endif
+#ifdef POOL_SLOT_MAP
+	if(!PP_(slot_map_reserve)(pool, slab))
+		{ PP_(slab_free)(pool, slab); return 0; }
+#endif
+	if(pool->slots.size && !live0)
+		is_recycled = 1, PP_(slab_free)(pool, base[0].slab);
+#else /* aligned --><!-- !aligned */
+#ifdef POOL_RETAIN
+	if(retained) {
+		slab = PP_(unretain)(pool, retained);
+		if(pool->slots.size && !live0)
+			is_recycled = 1, PP_(slab_free)(pool, base[0].slab);
+	} else
+#endif
+	if(pool->slots.size && !live0)
+		is_recycled = 1,
+		slab = PP_(realloc)(pool, base[0].slab, c * sizeof *slab);
+	else slab = PP_(malloc)(pool, c * sizeof *slab);
 	if(!slab) { if(!errno) errno = ERANGE; return 0; }
-	pool->capacity0 = c; /* We only need to store the capacity of slab 0. */
-	if(is_recycled) return base[0].size = 0, base[0].slab = slab, 1;
+#endif /* !aligned --> */
+	if(is_recycled) POOL_PROBE(slab_recycle, c, pool->capacity0);
+	else POOL_PROBE(slab_new, c, pool->capacity0);
+	pool->capacity = pool->capacity + c - (is_recycled ? pool->capacity0 : 0);
+	pool->capacity0 = c;
+	/* Holes in the old slab zero will never be reached again. */
+	PP_(free0_clear)(pool);
+#ifdef POOL_PAGE_FREE
+	PP_(pages_clear)(pool, 0);
+#endif
+	if(is_recycled) {
+		base[0].size = 0, base[0].slab = slab;
+		base[0].capacity = c;
+#ifdef POOL_SLOT_MAP
+		PP_(slot_map)(pool, 0, 1);
+#endif
+		PP_(peak_bytes)(pool);
+		return 1;
+	}
 
 	/* Evict slot 0. */
 	if(!pool->slots.size) insert = 0;
@@ -218,14 +1803,202 @@ static int PP_(buffer)(struct P_(pool) *const pool, const size_t n) {
 	assert(insert <= pool->slots.size);
 	slot = PP_(slot_array_insert)(&pool->slots, 1, insert);
 	assert(slot); /* Made space for it before. */
-	slot->slab = base[0].slab, slot->size = base[0].size;
+	slot->slab = base[0].slab, slot->size = live0;
 	base[0].slab = slab, base[0].size = 0;
+	slot->capacity = base[0].capacity, base[0].capacity = c;
+#ifdef POOL_SLOT_MAP
+	PP_(slot_map)(pool, 0, 1);
+	PP_(slot_map)(pool, insert, pool->slots.size);
+#endif
+	PP_(peak_bytes)(pool);
+	return 1;
+}
+#endif /* slabs --> */
+
+#ifdef POOL_INLINE_SLOTS /* <!-- inline */
+/** The slots of `pool` are in it. @return Zero. */
+static size_t PP_(slots_shrink)(struct P_(pool) *const pool)
+	{ return (void)pool, 0; }
+#else /* inline --><!-- array */
+/** Fits the slots of `pool` to it's size. @return The bytes given back. */
+static size_t PP_(slots_shrink)(struct P_(pool) *const pool) {
+	const size_t capacity = pool->slots.capacity;
+	if(!pool->slots.size) {
+		PP_(slot_array_)(&pool->slots);
+		return sizeof *pool->slots.data * capacity;
+	}
+	if(!PP_(slot_array_shrink)(&pool->slots)
+		|| pool->slots.capacity >= capacity) return 0;
+	return sizeof *pool->slots.data * (capacity - pool->slots.capacity);
+}
+#endif /* array --> */
+
+/** Frees slab zero of `pool`, the only slab, and empty. */
+static void PP_(trim0_free)(struct P_(pool) *const pool) {
+	assert(pool->slots.size == 1 && !pool->slots.data[0].size);
+	PP_(slab_free)(pool, pool->slots.data[0].slab);
+	pool->slots.size = 0, pool->capacity0 = pool->capacity = 0;
+	PP_(free0_clear)(pool);
+}
+#ifdef POOL_RESERVE /* <!-- reserve */
+/** Decommits the pages of slab zero in `pool` past the tail, or unmaps the
+ reservation if it's empty. @return The bytes given back. */
+static size_t PP_(trim0)(struct P_(pool) *const pool) {
+	const size_t page = (size_t)sysconf(_SC_PAGESIZE),
+		size0 = pool->slots.data[0].size,
+		committed = (pool->capacity0 * POOL_STRIDE + page - 1) & ~(page - 1),
+		bytes = (size0 * POOL_STRIDE + page - 1) & ~(page - 1);
+	char *const slab = (char *)(void *)pool->slots.data[0].slab;
+	if(!size0) { PP_(trim0_free)(pool); return committed; }
+	/* Mapping over it anew drops the pages, and keeps the reservation. */
+	if(bytes >= committed || mmap(slab + bytes, committed - bytes, PROT_NONE,
+		MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0) == MAP_FAILED)
+		return 0;
+#ifdef POOL_FREE_BITMAP
+	PP_(free0_contract)(pool, bytes / POOL_STRIDE);
+#endif
+	pool->slots.data[0].capacity = bytes / POOL_STRIDE;
+	pool->capacity0 = pool->capacity = bytes / POOL_STRIDE;
+	return committed - bytes;
+}
+#elif defined(POOL_HUGE) /* reserve --><!-- huge */
+/** Drops the whole huge pages of slab zero in `pool` past the tail, and
+ contracts it's capacity to the pages that are left, or unmaps it if it's
+ empty and the only one. The mapping stays whole until it's unmapped.
+ @return The bytes given back, at most. */
+static size_t PP_(trim0)(struct P_(pool) *const pool) {
+	struct PP_(slot) *const slot0 = pool->slots.data;
+	struct pool_huge_head *const head = PP_(huge_head)(slot0->slab);
+	const size_t committed = PP_(huge_bytes)(pool->capacity0),
+		tail = PP_(huge_bytes)(slot0->size);
+	size_t c;
+	assert(committed <= head->bytes && head->capacity == pool->capacity0);
+	if(!slot0->size && pool->slots.size == 1)
+		{ PP_(trim0_free)(pool); return committed; }
+	if(tail >= committed || madvise((char *)head + tail, committed - tail,
+		MADV_DONTNEED)) return 0;
+	c = (tail - sizeof *head) / POOL_STRIDE;
+	assert(slot0->size <= c && c < pool->capacity0);
+#ifdef POOL_FREE_BITMAP
+	PP_(free0_contract)(pool, c);
+#endif
+	head->capacity = slot0->capacity = c;
+	pool->capacity -= pool->capacity0 - c, pool->capacity0 = c;
+	return committed - tail;
+}
+#else /* huge --><!-- slabs */
+/** Frees slab zero of `pool` if it's empty and the only one, or, if it's just
+ empty, replaces it with the smallest slab. The items can't move, so slab
+ zero with items stays. @return The bytes given back. */
+static size_t PP_(trim0)(struct P_(pool) *const pool) {
+	struct PP_(slot) *const slot0 = pool->slots.data;
+	const size_t bytes = pool->capacity0 * POOL_STRIDE;
+	PP_(type) *slab;
+	if(slot0->size) return 0;
+	if(pool->slots.size == 1) { PP_(trim0_free)(pool); return bytes; }
+#ifdef POOL_BLOCK
+	(void)slab;
+	return 0; /* It's a whole block, whatever the capacity. */
+#else
+	if(pool->capacity0 <= POOL_SLAB_MIN_CAPACITY) return 0;
+#if defined(POOL_SLOT_MAP) \
+	|| defined(POOL_ALIGNMENT) || defined(POOL_COLOUR) /* <!-- aligned */
+	if(!(slab = PP_(slab_alloc)(pool, POOL_SLAB_MIN_CAPACITY))) return 0;
+#ifdef POOL_COLOUR
+	pool->colour++;
+#endif
+#ifdef POOL_SLOT_MAP
+	if(!PP_(slot_map_reserve)(pool, slab))
+		{ PP_(slab_free)(pool, slab); return 0; }
+#endif
+	PP_(slab_free)(pool, slot0->slab);
+#else /* aligned --><!-- !aligned */
+	if(!(slab = PP_(realloc)(pool, slot0->slab,
+		POOL_SLAB_MIN_CAPACITY * sizeof *slab))) return 0;
+#endif /* !aligned --> */
+	slot0->slab = slab;
+	slot0->capacity = POOL_SLAB_MIN_CAPACITY;
+#ifdef POOL_SLOT_MAP
+	PP_(slot_map)(pool, 0, 1);
+#endif
+	pool->capacity -= pool->capacity0 - POOL_SLAB_MIN_CAPACITY;
+	pool->capacity0 = POOL_SLAB_MIN_CAPACITY;
+	PP_(free0_clear)(pool);
+	return bytes - POOL_SLAB_MIN_CAPACITY * POOL_STRIDE;
+#endif
+}
+#endif /* slabs --> */
+
+/** @return Whether `pool` has room for `n` further items; if `is_run`, they
+ are adjacent at the tail, otherwise, the free-heap counts. */
+static int PP_(is_room)(const struct P_(pool) *const pool, const size_t n,
+	const int is_run) {
+	return pool->slots.size && n <= pool->capacity0
+		- pool->slots.data[0].size + (is_run ? 0 : PP_(free0_size)(pool));
+}
+
+/** Makes sure there is room for `n` further items in `pool`, adjacent if
+ `is_run`. If the limit of `POOL_LIMIT` is in the way, reclaim is called once,
+ and it tries again. @return Success. */
+static int PP_(room)(struct P_(pool) *const pool, const size_t n,
+	const int is_run) {
+	POOL_COUNT(room, 1);
+	if(PP_(is_room)(pool, n, is_run)) return 1;
+	POOL_COUNT(grow, 1);
+#ifdef POOL_LIMIT
+	if(PP_(grow)(pool, n)) return 1;
+	if(errno != POOL_LIMIT_ERRNO || !pool->reclaim) return 0;
+	if(!pool->reclaim(pool, n, pool->reclaim_param))
+		return errno = POOL_LIMIT_ERRNO, 0;
+	if(PP_(is_room)(pool, n, is_run)) return 1;
+#endif
+	return PP_(grow)(pool, n);
+}
+
+/** Makes sure there are space for `n` further items in `pool`.
+ @return Success. */
+static int PP_(buffer)(struct P_(pool) *const pool, const size_t n) {
+	assert(pool && (!pool->slots.size && !PP_(free0_size)(pool) /* !s0->!f0 */
+		|| pool->slots.size && pool->slots.data
+		&& pool->slots.data[0].size <= pool->capacity0
+		&& (!PP_(free0_size)(pool)
+		|| PP_(free0_size)(pool) < pool->slots.data[0].size)));
+	return !n || PP_(room)(pool, n, 0);
+}
+
+/** Removes `idx` from slab zero of `pool`; either the tail shrinks, or it gets
+ added to the free-heap. @return Success. It may fail due to a free-heap memory
+ allocation error; never with `POOL_FREE_LIST` or
+ `POOL_FREE_BITMAP`. @throws[realloc] */
+static int PP_(remove0)(struct P_(pool) *const pool, const size_t idx) {
+	struct PP_(slot) *const slot = pool->slots.data + 0;
+	assert(pool->capacity0 && slot->size <= pool->capacity0
+		&& idx < slot->size);
+	if(idx + 1 != slot->size) {
+		if(!PP_(free0_add)(pool, idx)) return 0;
+	} else {
+		const size_t size = slot->size;
+		/* Keep shrinking going while removed items are exposed. */
+		while(--slot->size && PP_(free0_pop_if)(pool, slot->size - 1));
+		if(slot->size + 1 < size) POOL_PROBE(tail_shrink, size, slot->size);
+	}
+#ifdef POOL_FREE_LIST
+	/* The list is not ordered, so the tail may be removed and not exposed;
+	 all removed is the only case that matters. */
+	if(PP_(free0_size)(pool) == slot->size)
+		PP_(free0_clear)(pool), slot->size = 0;
+#endif
+#ifdef POOL_PAGE_FREE
+	PP_(pages_remove)(pool, idx);
+#endif
 	return 1;
 }
 
 /** Either `data` in `pool` is in a secondary slab, in which case it decrements
- the size, or it's the zero-slab, where it gets added to the free-heap.
- @return Success. It may fail due to a free-heap memory allocation error.
+ the size, or it's the zero-slab, see <fn:<PP>remove0>.
+ @return Success. It may fail due to a free-heap memory allocation error;
+ never with `POOL_FREE_LIST` or
+ `POOL_FREE_BITMAP`.
  @order Amortized \O(\log \log `items`) @throws[realloc] */
 static int PP_(remove)(struct P_(pool) *const pool,
 	const PP_(type) *const data) {
@@ -233,40 +2006,197 @@ static int PP_(remove)(struct P_(pool) *const pool,
 	struct PP_(slot) *slot = pool->slots.data + c;
 	assert(pool && pool->slots.size && data);
 	if(!c) { /* It's in the zero-slot, we need to deal with the free-heap. */
-		const size_t idx = (size_t)(data - slot->slab);
-		assert(pool->capacity0 && slot->size <= pool->capacity0
-			&& idx < slot->size);
-		if(idx + 1 == slot->size) {
-			/* Keep shrinking going while item on the free-heap are exposed. */
-			while(--slot->size && poolfree_heap_size(&pool->free0)) {
-				const size_t free = *poolfree_heap_peek(&pool->free0);
-				if(free < slot->size - 1) break;
-				assert(free == slot->size - 1);
-				poolfree_heap_pop(&pool->free0);
-			}
-		} else if(!poolfree_heap_add(&pool->free0, idx)) return 0;
-	} else if(assert(slot->size), !--slot->size) {
-		PP_(type) *const slab = slot->slab;
-		PP_(slot_array_remove)(&pool->slots, pool->slots.data + c);
-		free(slab);
+		POOL_COUNT(remove0, 1);
+		if(!PP_(remove0)(pool, PP_(index)(slot->slab, data))) return 0;
+	} else if(POOL_COUNT(remove_slab, 1), assert(slot->size), !--slot->size) {
+		PP_(release)(pool, slot);
+		PP_(slot_array_remove)(&pool->slots, slot);
+#ifdef POOL_SLOT_MAP
+		PP_(slot_map)(pool, c, pool->slots.size);
+#endif
+	}
+	assert(pool->size);
+	pool->size--;
+	return 1;
+}
+
+/** Removes all `n` of `ptrs` from `pool`. Secondary slabs are decremented in
+ place and freed in one compaction at the end. Slab zero gets one sweep of the
+ tail and one heapify, using either a bitmap or a sort to know which indices
+ are removed, depending on how dense they are; with `POOL_FREE_LIST` or
+ `POOL_FREE_BITMAP`, each is \O(1) anyway.
+ @return Success; on failure, `pool` is unchanged. @throws[malloc, realloc]
+ @order \O(`n` + `slots` + `free0`) or \O(`n` \log `n`) for sparse */
+static int PP_(remove_n)(struct P_(pool) *const pool,
+	PP_(type) *const *const ptrs, const size_t n) {
+	struct PP_(slot) *const base = pool->slots.data, *s, *s1, *s_end;
+	PP_(type) *const slab0 = base[0].slab,
+		*const *p, *const *const p_end = ptrs + n;
+	size_t c = 0;
+#ifndef POOL_FREE_CONSTANT /* <!-- heap */
+	size_t k0 = 0, size0 = base[0].size, *idx = 0, *i, *i_end, *fill,
+		heap_capacity = pool->free0._.capacity;
+	unsigned char *bmp = 0;
+#endif /* heap --> */
+#define POOL_IS0(x) ((const void *)(x) >= (const void *)slab0 \
+	&& (const void *)(x) < (const void *)PP_(at)(slab0, pool->capacity0))
+	assert(pool && ptrs && n && pool->slots.size && base);
+
+#ifndef POOL_FREE_CONSTANT /* <!-- heap */
+	/* Everything that can fail is before any modification. */
+	for(p = ptrs; p < p_end; p++) if(POOL_IS0(*p)) k0++;
+	if(k0 && (!(idx = PF_(heap_buffer)(&pool->free0, k0)) || k0 >= size0 >> 9
+		&& !(bmp = PP_(calloc)(pool, size0 / CHAR_BIT + 1, 1))))
+		{ if(!errno) errno = ERANGE; return 0; }
+	if(pool->free0._.capacity != heap_capacity) {
+		POOL_PROBE(free0_grow, pool->free0._.size, pool->free0._.capacity);
+		PP_(peak_bytes)(pool);
+	}
+	i_end = idx;
+#endif /* heap --> */
+
+	assert(n <= pool->size);
+	pool->size -= n;
+	/* Slab-zero indices go after the free-heap, un-heaped; secondary slabs
+	 are remembered from the last one, since they are likely to be grouped. */
+	for(p = ptrs; p < p_end; p++) {
+		if(POOL_IS0(*p)) {
+#ifdef POOL_FREE_CONSTANT /* <!-- constant */
+			POOL_COUNT(remove0, 1);
+			PP_(remove0)(pool, PP_(index)(slab0, *p));
+#else /* constant --><!-- heap */
+			const size_t j = PP_(index)(slab0, *p);
+			POOL_COUNT(remove0, 1);
+			assert(j < size0);
+			*i_end++ = j;
+#ifdef POOL_PAGE_FREE
+			PP_(pages_remove)(pool, j);
+#endif
+			if(bmp) bmp[j / CHAR_BIT] |= (unsigned char)(1u << j % CHAR_BIT);
+#endif /* heap --> */
+			continue;
+		}
+#ifdef POOL_SLOT_MAP
+		c = PP_(slot_idx)(pool, *p);
+#else
+		if(!c || POOL_PTR *p < POOL_PTR base[c].slab
+			|| c + 1 < pool->slots.size
+			&& POOL_PTR base[c + 1].slab <= POOL_PTR *p)
+			c = PP_(upper)(&pool->slots, *p) - 1;
+#endif
+		assert(c && c < pool->slots.size && base[c].size);
+		POOL_COUNT(remove_slab, 1);
+		base[c].size--;
 	}
+#undef POOL_IS0
+	for(s1 = s = base + 1, s_end = base + pool->slots.size; s < s_end; s++) {
+		if(!s->size) { PP_(release)(pool, s); continue; }
+		if(s1 != s) *s1 = *s;
+		s1++;
+	}
+#ifdef POOL_SLOT_MAP
+	pool->slots.size = (size_t)(s1 - base);
+	if(s1 != s_end) PP_(slot_map)(pool, 1, pool->slots.size); /* Shifted. */
+#else
+	pool->slots.size = (size_t)(s1 - base);
+#endif
+
+#ifndef POOL_FREE_CONSTANT /* <!-- heap */
+	if(!k0) return 1;
+	/* One sweep down the tail: removed now, or already in the free-heap. */
+	if(!bmp) qsort(idx, k0, sizeof *idx, &pool_index_order);
+	for(i = i_end; size0; size0--) {
+		const size_t last = size0 - 1;
+		if(bmp ? bmp[last / CHAR_BIT] & 1u << last % CHAR_BIT
+			: i > idx && i[-1] == last) i--;
+		else if(!PP_(free0_pop_if)(pool, last)) break;
+	}
+	if(size0 < base[0].size) POOL_PROBE(tail_shrink, base[0].size, size0);
+	base[0].size = size0;
+	PP_(free)(pool, bmp);
+	/* Popping may have left a gap before the indices under the tail. */
+	for(fill = pool->free0._.data + pool->free0._.size, i = idx; i < i_end; i++)
+		if(*i < size0) *fill++ = *i;
+	if(fill != pool->free0._.data + pool->free0._.size)
+		PF_(heap_append)(&pool->free0,
+		(size_t)(fill - pool->free0._.data) - pool->free0._.size);
+#endif /* heap --> */
 	return 1;
 }
 
 /** @return An idle pool. @order \Theta(1) @allow */
 static struct P_(pool) P_(pool)(void) { struct P_(pool) p;
-	p.slots = PP_(slot_array)(), p.free0 = poolfree_heap(), p.capacity0 = 0;
+	p.slots = PP_(slot_array)();
+#if defined(POOL_FREE_LIST)
+	p.free0.head = p.free0.size = 0;
+#elif defined(POOL_FREE_BITMAP)
+	p.free0.bits = 0, p.free0.size = p.free0.hint = 0;
+#else
+	p.free0 = PF_(heap)();
+#endif
+	p.capacity0 = 0;
+	p.size = p.capacity = p.peak_size = p.peak_bytes = 0;
+#ifdef POOL_TRACE
+	p.trace = 0;
+#endif
+#ifdef POOL_SAMPLE
+	p.sample = 0;
+#endif
+#ifdef POOL_RADIX
+	p.radix = 0;
+#endif
+#ifdef POOL_ALLOCATOR
+	p.context = 0;
+#endif
+#ifdef POOL_COLOUR
+	p.colour = 0;
+#endif
+#ifdef POOL_RETAIN
+	p.retained_size = p.retained_bytes = p.epoch = 0;
+#endif
+#ifdef POOL_PAGE_FREE
+	p.page_live = 0, p.page_capacity = 0;
+#endif
+#ifdef POOL_LIMIT
+	p.limit = 0, p.reclaim = 0, p.reclaim_param = 0;
+#endif
 	return p; }
 
+#ifdef POOL_ALLOCATOR /* <!-- allocator */
+/** @return An idle pool that passes `context` to the allocator.
+ @order \Theta(1) @allow */
+static struct P_(pool) P_(pool_context)(void *const context)
+	{ struct P_(pool) p = P_(pool)(); p.context = context; return p; }
+#endif /* allocator --> */
+
 /** Destroys `pool` and returns it to idle. @order \O(\log `data`) @allow */
 static void P_(pool_)(struct P_(pool) *const pool) {
 	struct PP_(slot) *s, *s_end;
 	if(!pool) return;
+#ifdef POOL_TRACE
+	PP_(trace)(pool, POOL_TRACE_CLEAR, 0, 0, 0);
+#endif
+#ifdef POOL_SAMPLE
+	if(pool->sample) pool_sample_clear(pool->sample);
+#endif
 	for(s = pool->slots.data, s_end = s + pool->slots.size; s < s_end; s++)
-		assert(s->slab), free(s->slab);
+		assert(s->slab), PP_(slab_free)(pool, s->slab);
+#ifdef POOL_RETAIN
+	while(pool->retained_size) PP_(retained_shift)(pool);
+#endif
 	PP_(slot_array_)(&pool->slots);
-	poolfree_heap_(&pool->free0);
+	PP_(free0_)(pool);
+#ifdef POOL_RADIX
+	PP_(radix_)(pool);
+#endif
+#ifdef POOL_PAGE_FREE
+	PP_(free)(pool, pool->page_live);
+#endif
+#ifdef POOL_ALLOCATOR
+	*pool = P_(pool_context)(pool->context);
+#else
 	*pool = P_(pool)();
+#endif
 }
 
 /** Ensure capacity of at least `n` further items in `pool`. Pre-sizing is
@@ -281,41 +2211,304 @@ static int P_(pool_buffer)(struct P_(pool) *const pool, const size_t n) {
  @throws[ERANGE, malloc] @order amortised O(1) @allow */
 static PP_(type) *P_(pool_new)(struct P_(pool) *const pool) {
 	struct PP_(slot) *slot0;
+	size_t idx;
 	assert(pool);
 	if(!PP_(buffer)(pool, 1)) return 0;
-	assert(pool->slots.size && (pool->free0._.size ||
+	assert(pool->slots.size && (PP_(free0_size)(pool) ||
 		pool->slots.data[0].size < pool->capacity0));
-	if(poolfree_heap_size(&pool->free0)) {
-		/* Cheating: we prefer the minimum index from a max-heap, but it
-		 doesn't really matter, so take the one off the array used for heap. */
-		size_t *free;
-		free = heap_poolfree_node_array_pop(&pool->free0._);
-		return assert(free), pool->slots.data[0].slab + *free;
+	slot0 = pool->slots.data + 0;
+	if(PP_(free0_size)(pool)) {
+		POOL_COUNT(new_free0, 1);
+		idx = PP_(free0_take)(pool);
+	} else { /* The free-heap is empty; guaranteed by <fn:<PP>buffer>. */
+		assert(slot0 && slot0->size < pool->capacity0);
+		POOL_COUNT(new_tail, 1);
+		idx = slot0->size++;
 	}
-	/* The free-heap is empty; guaranteed by <fn:<PP>buffer>. */
+#ifdef POOL_PAGE_FREE
+	PP_(pages_new)(pool, idx, 1);
+#endif
+	PP_(count_new)(pool, 1);
+#ifdef POOL_TRACE
+	PP_(trace)(pool, POOL_TRACE_NEW, 0, PP_(at)(slot0->slab, idx), 1);
+#endif
+#ifdef POOL_SAMPLE
+	if(pool->sample && !--pool->sample->countdown)
+		pool_sample_record(pool->sample, PP_(at)(slot0->slab, idx));
+#endif
+	return PP_(at)(slot0->slab, idx);
+}
+
+/** Reserves `n` adjacent items from the tail of slab zero in `pool`. Each one
+ is a separate item as far as <fn:<P>pool_remove> is concerned.
+ @return A pointer to the first of `n` new uninitialized elements from `pool`,
+ or, if `n` is zero, null. @throws[ERANGE, malloc] @order amortised O(1)
+ @allow */
+static PP_(type) *P_(pool_new_n)(struct P_(pool) *const pool, const size_t n) {
+	struct PP_(slot) *slot0;
+	PP_(type) *run;
+	assert(pool);
+	if(!n) return 0;
+	/* Only the tail is contiguous; spare the free-heap. */
+	if(!PP_(room)(pool, n, 1)) return 0;
 	slot0 = pool->slots.data + 0;
-	assert(slot0 && slot0->size < pool->capacity0);
-	return slot0->slab + slot0->size++;
+	assert(pool->slots.size && n <= pool->capacity0 - slot0->size);
+#ifdef POOL_PAGE_FREE
+	PP_(pages_new)(pool, slot0->size, n);
+#endif
+	PP_(count_new)(pool, n);
+	POOL_COUNT(new_tail, n);
+	run = PP_(at)(slot0->slab, slot0->size), slot0->size += n;
+#ifdef POOL_TRACE
+	PP_(trace)(pool, POOL_TRACE_NEW, 0, run, n);
+#endif
+#ifdef POOL_SAMPLE
+	PP_(sample_new)(pool, 0, run, n);
+#endif
+	return run;
+}
+
+/** Fills `ptrs` with `n` new uninitialized elements from `pool`. Takes from the
+ free-heap of slab zero first, then the tail.
+ @return Success, in which case all of `ptrs` are valid, otherwise none are.
+ @throws[ERANGE, malloc] @order \O(`n`) @allow */
+static int P_(pool_new_ptrs)(struct P_(pool) *const pool,
+	PP_(type) **const ptrs, const size_t n) {
+	struct PP_(slot) *slot0;
+	size_t i = 0, f;
+	assert(pool && (ptrs || !n));
+	if(!PP_(buffer)(pool, n)) return 0;
+	if(!n) return 1;
+	slot0 = pool->slots.data + 0;
+	f = PP_(free0_size)(pool) < n ? PP_(free0_size)(pool) : n;
+#ifdef POOL_PAGE_FREE
+	for( ; i < f; i++) {
+		const size_t idx = PP_(free0_take)(pool);
+		PP_(pages_new)(pool, idx, 1);
+		ptrs[i] = PP_(at)(slot0->slab, idx);
+	}
+	if(i < n) PP_(pages_new)(pool, slot0->size, n - i);
+#else
+	while(i < f) ptrs[i++] = PP_(at)(slot0->slab, PP_(free0_take)(pool));
+#endif
+	assert(n - i <= pool->capacity0 - slot0->size);
+	while(i < n) ptrs[i++] = PP_(at)(slot0->slab, slot0->size++);
+	PP_(count_new)(pool, n);
+	POOL_COUNT(new_free0, f), POOL_COUNT(new_tail, n - f);
+#ifdef POOL_TRACE
+	PP_(trace)(pool, POOL_TRACE_NEW, ptrs, 0, n);
+#endif
+#ifdef POOL_SAMPLE
+	PP_(sample_new)(pool, ptrs, 0, n);
+#endif
+	return 1;
 }
 
 /** Deletes `data` from `pool`. Do not remove data that is not in `pool`.
- @return Success. @order \O(\log \log `items`) @allow */
+ @return Success; with `POOL_FREE_LIST` or `POOL_FREE_BITMAP`, always.
+ @throws[realloc] Only the free-heap.
+ @order \O(\log \log `items`) @allow */
 static int P_(pool_remove)(struct P_(pool) *const pool,
-	PP_(type) *const data) { return PP_(remove)(pool, data); }
+	PP_(type) *const data) {
+#if defined(POOL_TRACE) || defined(POOL_SAMPLE)
+	if(!PP_(remove)(pool, data)) return 0;
+#ifdef POOL_TRACE
+	PP_(trace)(pool, POOL_TRACE_REMOVE, 0, data, 1);
+#endif
+#ifdef POOL_SAMPLE
+	PP_(sample_remove)(pool, 0, data, 1);
+#endif
+	return 1;
+#else
+	return PP_(remove)(pool, data);
+#endif
+}
+
+/** Deletes all `n` of `ptrs` from `pool`; it's faster than calling
+ <fn:<P>pool_remove> `n` times. Do not remove data that is not in `pool` or
+ the same data twice.
+ @return Success; on failure, none are removed. @throws[malloc, realloc]
+ @order \O(`n`) @allow */
+static int P_(pool_remove_n)(struct P_(pool) *const pool,
+	PP_(type) *const *const ptrs, const size_t n) {
+	assert(pool && (ptrs || !n));
+	if(!n) return 1;
+	if(!PP_(remove_n)(pool, ptrs, n)) return 0;
+#ifdef POOL_TRACE
+	PP_(trace)(pool, POOL_TRACE_REMOVE, ptrs, 0, n);
+#endif
+#ifdef POOL_SAMPLE
+	PP_(sample_remove)(pool, ptrs, 0, n);
+#endif
+	return 1;
+}
 
 /** Removes all from `pool`, but keeps it's active state, only freeing the
  smaller blocks. @order \O(\log `items`) @allow */
 static void P_(pool_clear)(struct P_(pool) *const pool) {
 	struct PP_(slot) *s, *s_end;
 	assert(pool);
-	if(!pool->slots.size) { assert(!pool->free0._.size); return; }
+#ifdef POOL_TRACE
+	PP_(trace)(pool, POOL_TRACE_CLEAR, 0, 0, 0);
+#endif
+#ifdef POOL_SAMPLE
+	if(pool->sample) pool_sample_clear(pool->sample);
+#endif
+	if(!pool->slots.size) { assert(!PP_(free0_size)(pool)); return; }
 	for(s = pool->slots.data + 1, s_end = s - 1 + pool->slots.size;
-		s < s_end; s++) assert(s->slab && s->size), free(s->slab);
+		s < s_end; s++) assert(s->slab && s->size),
+		PP_(release)(pool, s);
+#ifdef POOL_PAGE_FREE
+	PP_(pages_clear)(pool, 1);
+#endif
 	pool->slots.data[0].size = 0;
 	pool->slots.size = 1;
-	poolfree_heap_clear(&pool->free0);
+	pool->size = 0, pool->capacity = pool->capacity0;
+	PP_(free0_clear)(pool);
+}
+
+/** Gives memory that `pool` is not using back to the system, as after a
+ spike: the retained slabs; the slots and the free-heap past their size; and
+ slab zero. If slab zero is empty, it's freed if it's the only slab, or else
+ replaced by the smallest. Slab zero with items can't move, so only with
+ `POOL_HUGE` or `POOL_RESERVE` are the pages past it's tail given back, and
+ it's capacity contracted to what's left. It doesn't fail; whatever can't be
+ shrunk stays.
+ @return The bytes given back. @order \O(`slots` + `capacity0`) @allow */
+static size_t P_(pool_trim)(struct P_(pool) *const pool) {
+	const int e = errno; /* Shrinking may fail harmlessly. */
+	size_t capacity0, bytes = 0;
+	assert(pool);
+	capacity0 = pool->capacity0;
+#ifdef POOL_RETAIN
+	bytes += pool->retained_bytes;
+	while(pool->retained_size) PP_(retained_shift)(pool);
+#endif
+	if(pool->slots.size) bytes += PP_(trim0)(pool);
+	bytes += PP_(free0_shrink)(pool, capacity0);
+#ifdef POOL_PAGE_FREE
+	bytes += PP_(pages_shrink)(pool);
+#endif
+	bytes += PP_(slots_shrink)(pool);
+	errno = e;
+	return bytes;
 }
 
+/** Fills `stats` with the state of `pool`. The fragmentation is the free
+ space that's not at the tail of slab zero: removed items in slab zero and
+ in the secondary slabs, over the capacity of all the slabs.
+ @order \Theta(1) @allow */
+static void P_(pool_stats)(const struct P_(pool) *const pool,
+	struct P_(pool_stats) *const stats) {
+	assert(pool && stats);
+	stats->size = pool->size;
+	stats->capacity = pool->capacity;
+	stats->capacity0 = pool->capacity0;
+	stats->slabs = pool->slots.size;
+	stats->free0 = PP_(free0_size)(pool);
+	stats->free0_bytes = PP_(free0_bytes)(pool);
+	stats->metadata = PP_(metadata)(pool);
+	stats->bytes = PP_(footprint)(pool);
+	stats->peak_size = pool->peak_size;
+	stats->peak_bytes = pool->peak_bytes;
+	/* The tail of slab zero is free, but not fragmented. */
+	stats->fragmentation = pool->capacity ? (double)(pool->capacity
+		- pool->size - (pool->capacity0 - (pool->slots.size
+		? pool->slots.data[0].size : 0))) / (double)pool->capacity : 0.0;
+#ifdef POOL_COLOUR
+	stats->base_colour = PP_(base_colour)(pool);
+	stats->next_colour = PP_(colour)(pool);
+#endif
+}
+
+#ifdef POOL_STATS /* <!-- stats */
+/** Fills `counters` with the counts of all the pools of this type. They may
+ be in the middle of changing if other threads are using pools.
+ @order \Theta(1) @allow */
+static void P_(pool_counters)(struct P_(pool_counters) *const counters) {
+	assert(counters);
+	counters->new_free0 = POOL_LOAD(&PP_(count).new_free0, POOL_RELAXED);
+	counters->new_tail = POOL_LOAD(&PP_(count).new_tail, POOL_RELAXED);
+	counters->room = POOL_LOAD(&PP_(count).room, POOL_RELAXED);
+	counters->grow = POOL_LOAD(&PP_(count).grow, POOL_RELAXED);
+	counters->remove0 = POOL_LOAD(&PP_(count).remove0, POOL_RELAXED);
+	counters->remove_slab = POOL_LOAD(&PP_(count).remove_slab, POOL_RELAXED);
+	counters->release = POOL_LOAD(&PP_(count).release, POOL_RELAXED);
+	counters->upper = POOL_LOAD(&PP_(count).upper, POOL_RELAXED);
+	counters->upper_depth = POOL_LOAD(&PP_(count).upper_depth, POOL_RELAXED);
+}
+
+/** Zeroes the counts of all the pools of this type. @order \Theta(1) @allow */
+static void P_(pool_counters_clear)(void) {
+	POOL_STORE(&PP_(count).new_free0, 0, POOL_RELAXED);
+	POOL_STORE(&PP_(count).new_tail, 0, POOL_RELAXED);
+	POOL_STORE(&PP_(count).room, 0, POOL_RELAXED);
+	POOL_STORE(&PP_(count).grow, 0, POOL_RELAXED);
+	POOL_STORE(&PP_(count).remove0, 0, POOL_RELAXED);
+	POOL_STORE(&PP_(count).remove_slab, 0, POOL_RELAXED);
+	POOL_STORE(&PP_(count).release, 0, POOL_RELAXED);
+	POOL_STORE(&PP_(count).upper, 0, POOL_RELAXED);
+	POOL_STORE(&PP_(count).upper_depth, 0, POOL_RELAXED);
+}
+
+/** Prints the counts of all the pools of this type on one line to `fp`, to
+ go beside timings. @return Success. @throws[fprintf] @allow */
+static int P_(pool_counters_print)(FILE *const fp) {
+	struct P_(pool_counters) c;
+	assert(fp);
+	P_(pool_counters)(&c);
+	return fprintf(fp, "new free0 %lu tail %lu; room %lu grow %lu; "
+		"remove slab0 %lu secondary %lu release %lu; upper %lu depth %lu\n",
+		(unsigned long)c.new_free0, (unsigned long)c.new_tail,
+		(unsigned long)c.room, (unsigned long)c.grow,
+		(unsigned long)c.remove0, (unsigned long)c.remove_slab,
+		(unsigned long)c.release, (unsigned long)c.upper,
+		(unsigned long)c.upper_depth) >= 0;
+}
+#endif /* stats --> */
+
+#ifdef POOL_TRACE /* <!-- trace */
+/** Records the items that `pool` makes and removes from now on in `trace`,
+ which has been started with <fn:pool_trace_begin>; null, as it is
+ initially, stops. `pool` doesn't own it, and it should only have the one
+ pool. @order \Theta(1) @allow */
+static void P_(pool_set_trace)(struct P_(pool) *const pool,
+	struct pool_trace *const trace) { assert(pool); pool->trace = trace; }
+#endif /* trace --> */
+
+#ifdef POOL_SAMPLE /* <!-- sample */
+/** Samples the items that `pool` makes from now on in `sample`, which has
+ been started with <fn:pool_sample_begin>; null, as it is initially, stops.
+ The items that are live before aren't in it. `pool` doesn't own it, and it
+ should only have the one pool. See <fn:pool_sample_report>.
+ @order \Theta(1) @allow */
+static void P_(pool_set_sample)(struct P_(pool) *const pool,
+	struct pool_sample *const sample) {
+	assert(pool);
+	if((pool->sample = sample)) sample->item_size = POOL_STRIDE;
+}
+#endif /* sample --> */
+
+#ifdef POOL_LIMIT /* <!-- limit */
+/** Limits `pool` to `bytes`, counting the items of all it's slabs, retained
+ or not, and it's slots and free-heap; zero, as it is initially, is no limit.
+ When slab zero grows, it's clamped to the limit; if the items asked for
+ don't fit, reclaim is called, see <fn:<P>pool_set_reclaim>, and then it
+ fails with `ENOBUFS`, or `EDOM` where that's not defined. The limit is only
+ checked when slab zero grows, so the slots and free-heap that follow may go
+ over by a little. It doesn't free anything if `pool` is already over; see
+ <fn:<P>pool_trim>. @order \Theta(1) @allow */
+static void P_(pool_set_limit)(struct P_(pool) *const pool, const size_t bytes)
+	{ assert(pool); pool->limit = bytes; }
+
+/** Sets `reclaim` to be called once, with `param`, when `pool` can't grow
+ within it's limit, before it fails; null, as it is initially, fails
+ straight away. @order \Theta(1) @allow */
+static void P_(pool_set_reclaim)(struct P_(pool) *const pool,
+	const PP_(reclaim_fn) reclaim, void *const param)
+	{ assert(pool); pool->reclaim = reclaim, pool->reclaim_param = param; }
+#endif /* limit --> */
+
 #ifdef POOL_TEST /* <!-- test */
 /* Forward-declare. */
 static void (*PP_(to_string))(const PP_(type) *, char (*)[12]);
@@ -327,7 +2520,35 @@ static void PP_(unused_base_coda)(void);
 static void PP_(unused_base)(void) {
 	PP_(is_element_c)(0); PP_(forward)(0); PP_(next_c)(0);
 	P_(pool)(); P_(pool_)(0); P_(pool_buffer)(0, 0); P_(pool_new)(0);
-	P_(pool_remove)(0, 0); P_(pool_clear)(0); PP_(unused_base_coda)();
+	P_(pool_new_n)(0, 0); P_(pool_new_ptrs)(0, 0, 0); P_(pool_remove)(0, 0);
+	P_(pool_remove_n)(0, 0, 0); P_(pool_clear)(0); P_(pool_trim)(0);
+	P_(pool_stats)(0, 0); pool_index_order(0, 0); pool_words(0);
+	pool_ctz(1); pool_nonzero(0, 0, 0);
+	PP_(malloc)(0, 0); PP_(realloc)(0, 0, 0); PP_(free)(0, 0);
+	PP_(calloc)(0, 0, 0);
+#ifdef POOL_ALLOCATOR
+	P_(pool_context)(0);
+#endif
+#if defined(POOL_SLOT_MAP) || defined(POOL_HUGE)
+	PP_(slab_capacity)(0);
+#endif
+#ifdef POOL_COLOUR
+	PP_(slab_head)(0);
+#endif
+#ifdef POOL_LIMIT
+	P_(pool_set_limit)(0, 0); P_(pool_set_reclaim)(0, 0, 0);
+#endif
+#ifdef POOL_STATS
+	P_(pool_counters)(0); P_(pool_counters_clear)();
+	P_(pool_counters_print)(0);
+#endif
+#ifdef POOL_TRACE
+	P_(pool_set_trace)(0, 0);
+#endif
+#ifdef POOL_SAMPLE
+	P_(pool_set_sample)(0, 0);
+#endif
+	PP_(unused_base_coda)();
 }
 static void PP_(unused_base_coda)(void) { PP_(unused_base)(); }
 
@@ -366,6 +2587,97 @@ static const char *(*PP_(pool_to_string))(const struct P_(pool) *)
 #endif
 #undef POOL_NAME
 #undef POOL_TYPE
+#ifdef POOL_FREE_LIST
+#undef POOL_FREE_LIST
+#endif
+#ifdef POOL_FREE_BITMAP
+#undef POOL_FREE_BITMAP
+#endif
+#ifdef POOL_RADIX
+#undef POOL_RADIX
+#undef POOL_RADIX_LEAF
+#undef POOL_RADIX_MID
+#undef POOL_RADIX_ROOT
+#undef POOL_RADIX_SHIFT
+#undef POOL_RADIX_MASK
+#endif
+#ifdef POOL_BLOCK
+#undef POOL_BLOCK
+#undef POOL_BLOCK_MASK
+#endif
+#ifdef POOL_HUGE
+#undef POOL_HUGE
+#undef POOL_HUGE_MASK
+#endif
+#ifdef POOL_RESERVE
+#undef POOL_RESERVE
+#endif
+#ifdef POOL_ALIGN
+#undef POOL_ALIGN
+#endif
+#ifdef POOL_CACHELINE_ISOLATE
+#undef POOL_CACHELINE_ISOLATE
+#endif
+#ifdef POOL_ALIGNMENT
+#undef POOL_ALIGNMENT
+#endif
+#ifdef POOL_COLOUR
+#undef POOL_COLOUR
+#undef POOL_COLOUR_LINE
+#endif
+#ifdef POOL_RETAIN
+#undef POOL_RETAIN
+#undef POOL_RETAIN_BYTES
+#undef POOL_RETAIN_DECAY
+#endif
+#ifdef POOL_PAGE_FREE
+#undef POOL_PAGE_FREE
+#undef POOL_PAGE
+#endif
+#ifdef POOL_LIMIT
+#undef POOL_LIMIT
+#undef POOL_LIMIT_ERRNO
+#endif
+#ifdef POOL_STATS
+#undef POOL_STATS
+#endif
+#ifdef POOL_TRACE
+#undef POOL_TRACE
+#endif
+#ifdef POOL_SAMPLE
+#undef POOL_SAMPLE
+#endif
+#ifdef POOL_USDT
+#undef POOL_USDT
+#undef POOL_PROBE_NAME_
+#undef POOL_PROBE_NAME
+#endif
+#undef POOL_PROBE
+#undef POOL_COUNT
+#ifdef POOL_SLAB_ALIGN
+#undef POOL_SLAB_ALIGN
+#undef POOL_SLAB_SLACK
+#endif
+#undef POOL_STRIDE
+#ifdef POOL_SLOT_MAP
+#undef POOL_SLOT_MAP
+#endif
+#ifdef POOL_INLINE_SLOTS
+#undef POOL_INLINE_SLOTS
+#undef POOL_SLOT_MAX
+#endif
+#ifdef POOL_ALLOCATOR
+#undef POOL_ALLOCATOR
+#undef POOL_ALLOC
+#undef POOL_REALLOC
+#undef POOL_FREE
+#endif
+#ifdef PF_
+#undef PF_
+#endif
+#ifdef POOL_FREE_CONSTANT
+#undef POOL_FREE_CONSTANT
+#endif
 #undef BOX_
 #undef BOX
 #undef BOX_CONTENT
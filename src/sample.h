@@ -0,0 +1,258 @@
+/** @license 2021 Neil Edelman, distributed under the terms of the
+ [MIT License](https://opensource.org/licenses/MIT).
+
+ @abstract Header <src/sample.h> is used by <src/pool.h> with `POOL_SAMPLE`.
+
+ @subtitle Sampled allocation profiles
+
+ A <tag:pool_sample> attributes the items that are live in a pool to the call
+ stacks that made them, so that when one pool balloons, it can say who is
+ holding on. Recording a stack on every new would be too slow; instead, about
+ one in `rate` new items, chosen by a count-down with random jitter so it
+ doesn't alias with a loop, has a short backtrace taken. The item is keyed in
+ an open-addressing table to it's stack, and removing it, or clearing the
+ pool, takes it out. <fn:pool_sample_report> lists the stacks by the live
+ sampled items, and estimates the bytes by scaling up by the rate.
+
+ Off the sample, a new is a decrement, and a remove is a probe of the table,
+ which has only the live samples, if there are any.
+
+ @param[POOL_SAMPLE_DEPTH]
+ The frames kept in a stack; defaults to 12. The first few are the pool.
+
+ @std C89 and <execinfo.h> `backtrace` */
+
+#ifndef SAMPLE_H /* <!-- idempotent */
+#define SAMPLE_H
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <execinfo.h>
+#ifndef POOL_SAMPLE_DEPTH
+#define POOL_SAMPLE_DEPTH 12
+#endif
+#if POOL_SAMPLE_DEPTH < 1
+#error POOL_SAMPLE_DEPTH has to be at least one.
+#endif
+
+/** A call stack that made sampled items. */
+struct pool_sample_stack {
+	void *frame[POOL_SAMPLE_DEPTH];
+	int depth;
+	unsigned long hash;
+	size_t live, total; /* Sampled items. */
+};
+
+/** A sampled item that is live, and the index of it's stack. */
+struct pool_sample_item { const void *item; size_t stack; };
+
+/** A profile that is being sampled. Set up with <fn:pool_sample_begin>, and
+ attach to one pool. */
+struct pool_sample {
+	size_t rate, countdown; /* One in `rate`; new items until the next. */
+	unsigned long random;
+	size_t item_size; /* Set by the pool. */
+	struct { struct pool_sample_stack *data; size_t size, capacity; } stacks;
+	/* Open-addressing, linear probing, a power of two, at most half full. */
+	struct { struct pool_sample_item *data; size_t size, capacity; } live;
+	size_t dropped; /* Samples that couldn't be recorded. */
+	int error; /* The first. */
+};
+
+/** @return The next count-down of `s`, uniform in [1, `2 rate - 1`], so the
+ mean is `rate`. */
+static size_t pool_sample_countdown(struct pool_sample *const s) {
+	s->random = (s->random * 1103515245ul + 12345ul) & 0xfffffffful;
+	return s->rate > 1 ? 1 + (size_t)(s->random >> 8) % (2 * s->rate - 1) : 1;
+}
+
+/** Sets `s` to sample one in `rate` items, on average; it can be changed
+ while sampling. A `rate` of one records every item. */
+static void pool_sample_rate(struct pool_sample *const s, const size_t rate) {
+	assert(s && rate);
+	s->rate = rate, s->countdown = pool_sample_countdown(s);
+}
+
+/** Starts `s`, sampling one in `rate` items. */
+static void pool_sample_begin(struct pool_sample *const s, const size_t rate) {
+	assert(s && rate);
+	s->random = (unsigned long)(size_t)s;
+	s->item_size = 0;
+	s->stacks.data = 0, s->stacks.size = s->stacks.capacity = 0;
+	s->live.data = 0, s->live.size = s->live.capacity = 0;
+	s->dropped = 0, s->error = 0;
+	pool_sample_rate(s, rate);
+}
+
+/** Frees `s`. @return Whether every sample was recorded. */
+static int pool_sample_end(struct pool_sample *const s) {
+	int success;
+	if(!s) return 1;
+	success = !s->error || (errno = s->error, 0);
+	free(s->stacks.data), free(s->live.data);
+	s->stacks.data = 0, s->stacks.size = s->stacks.capacity = 0;
+	s->live.data = 0, s->live.size = s->live.capacity = 0;
+	return success;
+}
+
+/** @return The first bucket of `item` in the table of `s`. */
+static size_t pool_sample_bucket(const struct pool_sample *const s,
+	const void *const item) {
+	unsigned long h = (unsigned long)(size_t)item;
+	h ^= h >> 7, h = (h * 2654435761ul) & 0xfffffffful, h ^= h >> 15;
+	return (size_t)h & (s->live.capacity - 1);
+}
+
+/** Puts `item`, sampled from `stack`, in `s`. @return Success. */
+static int pool_sample_put(struct pool_sample *const s, const void *const item,
+	const size_t stack) {
+	struct pool_sample_item *x;
+	size_t i;
+	if(2 * (s->live.size + 1) > s->live.capacity) {
+		struct pool_sample_item *const old = s->live.data;
+		const size_t old_capacity = s->live.capacity,
+			c = old_capacity ? 2 * old_capacity : 32;
+		if(c < old_capacity || !(x = calloc(c, sizeof *x))) return 0;
+		s->live.data = x, s->live.capacity = c, s->live.size = 0;
+		for(i = 0; i < old_capacity; i++)
+			if(old[i].item) pool_sample_put(s, old[i].item, old[i].stack);
+		free(old);
+	}
+	x = s->live.data;
+	for(i = pool_sample_bucket(s, item); x[i].item;
+		i = (i + 1) & (s->live.capacity - 1)) assert(x[i].item != item);
+	x[i].item = item, x[i].stack = stack, s->live.size++;
+	return 1;
+}
+
+/** @return The index of the stack of the caller in `s`, or `size` on
+ failure. There are few stacks, so they are searched linearly. */
+static size_t pool_sample_stack(struct pool_sample *const s) {
+	struct pool_sample_stack *stack;
+	void *frame[POOL_SAMPLE_DEPTH];
+	const int depth = backtrace(frame, POOL_SAMPLE_DEPTH);
+	unsigned long hash = 0;
+	size_t i;
+	for(i = 0; i < (size_t)depth; i++)
+		hash = (hash * 31 + (unsigned long)(size_t)frame[i]) & 0xfffffffful;
+	for(i = 0; i < s->stacks.size; i++) {
+		stack = s->stacks.data + i;
+		if(stack->hash == hash && stack->depth == depth
+			&& !memcmp(stack->frame, frame, sizeof *frame * (size_t)depth))
+			return i;
+	}
+	if(s->stacks.size >= s->stacks.capacity) {
+		const size_t c = s->stacks.capacity ? 2 * s->stacks.capacity : 8;
+		if(c < s->stacks.capacity || !(stack
+			= realloc(s->stacks.data, sizeof *stack * c))) return i;
+		s->stacks.data = stack, s->stacks.capacity = c;
+	}
+	stack = s->stacks.data + s->stacks.size++;
+	memcpy(stack->frame, frame, sizeof *frame * (size_t)depth);
+	stack->depth = depth, stack->hash = hash, stack->live = stack->total = 0;
+	return i;
+}
+
+/** Samples `item`, which just came from the pool, in `s`, and starts the
+ next count-down. Failing to allocate drops the sample, see
+ <fn:pool_sample_end>. */
+static void pool_sample_record(struct pool_sample *const s,
+	const void *const item) {
+	size_t i;
+	assert(s && item);
+	s->countdown = pool_sample_countdown(s);
+	if((i = pool_sample_stack(s)) == s->stacks.size
+		|| !pool_sample_put(s, item, i)) {
+		if(!s->error) s->error = errno ? errno : ENOMEM;
+		s->dropped++;
+		return;
+	}
+	s->stacks.data[i].live++, s->stacks.data[i].total++;
+}
+
+/** Takes `item`, which is being removed from the pool, out of `s`, if it was
+ sampled. */
+static void pool_sample_remove(struct pool_sample *const s,
+	const void *const item) {
+	const size_t mask = s->live.capacity - 1;
+	struct pool_sample_item *const data = s->live.data;
+	size_t i, j, k;
+	assert(s && item);
+	if(!s->live.size) return;
+	for(i = pool_sample_bucket(s, item); data[i].item != item;
+		i = (i + 1) & mask) if(!data[i].item) return;
+	assert(s->stacks.data[data[i].stack].live);
+	s->stacks.data[data[i].stack].live--;
+	s->live.size--;
+	/* Shift the run back over the hole, so probes don't stop early. */
+	for(j = (i + 1) & mask; data[j].item; j = (j + 1) & mask) {
+		k = pool_sample_bucket(s, data[j].item);
+		if(((j - k) & mask) < ((j - i) & mask)) continue;
+		data[i] = data[j], i = j;
+	}
+	data[i].item = 0;
+}
+
+/** All the items in the pool of `s` are gone. */
+static void pool_sample_clear(struct pool_sample *const s) {
+	size_t i;
+	assert(s);
+	for(i = 0; i < s->stacks.size; i++) s->stacks.data[i].live = 0;
+	if(s->live.size) memset(s->live.data, 0,
+		sizeof *s->live.data * s->live.capacity), s->live.size = 0;
+}
+
+/** Orders by live, most first. @implements `qsort` */
+static int pool_sample_order(const void *const a, const void *const b) {
+	const struct pool_sample_stack *const x
+		= *(const struct pool_sample_stack *const *)a,
+		*const y = *(const struct pool_sample_stack *const *)b;
+	return (x->live < y->live) - (x->live > y->live);
+}
+
+/** Outputs the stacks of `s` with live samples to `fp`, most first, with the
+ bytes that are estimated to be live from each.
+ @return Success. @throws[malloc, fprintf] */
+static int pool_sample_report(const struct pool_sample *const s,
+	FILE *const fp) {
+	const struct pool_sample_stack **order;
+	const size_t scale = s->rate * s->item_size;
+	size_t i, n;
+	int j;
+	assert(s && fp);
+	if(!(order = malloc(sizeof *order * (s->stacks.size + !s->stacks.size))))
+		return 0;
+	for(i = n = 0; i < s->stacks.size; i++)
+		if(s->stacks.data[i].live) order[n++] = s->stacks.data + i;
+	qsort(order, n, sizeof *order, &pool_sample_order);
+	fprintf(fp, "Sampled 1 in %lu: %lu live, ~%lu bytes, in %lu of %lu stacks"
+		"%s.\n", (unsigned long)s->rate, (unsigned long)s->live.size,
+		(unsigned long)(s->live.size * scale), (unsigned long)n,
+		(unsigned long)s->stacks.size, s->dropped ? ", some dropped" : "");
+	for(i = 0; i < n; i++) {
+		char **const symbol = backtrace_symbols(order[i]->frame,
+			order[i]->depth);
+		fprintf(fp, "~%lu bytes: %lu live of %lu sampled.\n",
+			(unsigned long)(order[i]->live * scale),
+			(unsigned long)order[i]->live, (unsigned long)order[i]->total);
+		for(j = 0; j < order[i]->depth; j++) {
+			if(symbol) fprintf(fp, "\t%s\n", symbol[j]);
+			else fprintf(fp, "\t%p\n", order[i]->frame[j]);
+		}
+		free(symbol);
+	}
+	free(order);
+	return !ferror(fp);
+}
+
+static void pool_sample_unused_coda(void);
+static void pool_sample_unused(void) {
+	pool_sample_begin(0, 0); pool_sample_end(0); pool_sample_record(0, 0);
+	pool_sample_remove(0, 0); pool_sample_clear(0); pool_sample_report(0, 0);
+	pool_sample_unused_coda();
+}
+static void pool_sample_unused_coda(void) { pool_sample_unused(); }
+
+#endif /* idempotent --> */
@@ -0,0 +1,177 @@
+/** @license 2021 Neil Edelman, distributed under the terms of the
+ [MIT License](https://opensource.org/licenses/MIT).
+
+ @abstract Header <src/trace.h> is used by <src/pool.h> with `POOL_TRACE`,
+ and the replay in <timing/test/replay.c>.
+
+ @subtitle Allocation traces
+
+ A <tag:pool_trace> records the items that a pool makes and removes as a
+ compact binary stream, so that real traffic can be replayed later against
+ another allocator. It is a magic number, `pooltrc1`, and the size of an
+ item, followed by events. Each event is the nanoseconds since the last
+ shifted left by two, with the <tag:pool_trace_op> in the low bits, then, for
+ new and remove, the difference of the address of the item from the last
+ one, zig-zagged. All are base-128 variable-length, low first, so an event
+ is usually a few bytes.
+
+ Addresses are not unique over time, but they are while an item is live; a
+ reader, <fn:pool_trace_next>, gives the address, and the replay numbers the
+ lifetimes.
+
+ @std C89 and POSIX `clock_gettime` */
+
+#ifndef TRACE_H /* <!-- idempotent */
+#define TRACE_H
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+#include <time.h>
+#ifndef CLOCK_MONOTONIC
+#error Traces need CLOCK_MONOTONIC; define _DEFAULT_SOURCE before includes.
+#endif
+#if !defined(__STDC__) || !defined(__STDC_VERSION__) \
+	|| __STDC_VERSION__ < 199901L /* < C99 */
+typedef unsigned long pool_trace_address;
+#else /* < C99 --><!-- >= C99 */
+#include <stdint.h>
+typedef uintptr_t pool_trace_address;
+#endif /* >= C99 --> */
+
+/** What happened to the pool. A clear removes all the items that are live,
+ so there should be one pool to a trace. */
+enum pool_trace_op { POOL_TRACE_NEW, POOL_TRACE_REMOVE, POOL_TRACE_CLEAR };
+
+/** A trace that is being written or read. Set up with
+ <fn:pool_trace_begin> or <fn:pool_trace_read>; the stream is not owned. */
+struct pool_trace {
+	FILE *fp;
+	pool_trace_address address; /* Of the last event. */
+	struct timespec time; /* Of the last event, writing. */
+	int error; /* The first. */
+};
+
+/** One event read by <fn:pool_trace_next>. */
+struct pool_trace_event {
+	enum pool_trace_op op;
+	pool_trace_address address; /* Of the item, unless a clear. */
+	unsigned long ns; /* Since the last event. */
+};
+
+static const char pool_trace_magic[8] = { 'p','o','o','l','t','r','c','1' };
+
+/** Writes `x` to `trace` in base-128, low first. */
+static void pool_trace_put(struct pool_trace *const trace,
+	pool_trace_address x) {
+	unsigned char buf[sizeof x * 8 / 7 + 1], *b = buf;
+	do { *b = (unsigned char)(x & 0x7f), x >>= 7; if(x) *b |= 0x80; b++; }
+	while(x);
+	if(!trace->error && fwrite(buf, 1, (size_t)(b - buf), trace->fp)
+		!= (size_t)(b - buf)) trace->error = errno ? errno : EIO;
+}
+
+/** Reads `x` from `trace` in base-128, low first. @return Success. */
+static int pool_trace_get(struct pool_trace *const trace,
+	pool_trace_address *const x) {
+	unsigned shift = 0;
+	int c;
+	*x = 0;
+	do {
+		if((c = getc(trace->fp)) == EOF) return 0;
+		if(shift >= sizeof *x * 8) return trace->error = EILSEQ, 0;
+		*x |= (pool_trace_address)(c & 0x7f) << shift, shift += 7;
+	} while(c & 0x80);
+	return 1;
+}
+
+/** Starts `trace` on `fp`, open for writing, for items of `size`.
+ @return Success. @throws[fwrite, clock_gettime] */
+static int pool_trace_begin(struct pool_trace *const trace, FILE *const fp,
+	const size_t size) {
+	assert(trace && fp);
+	trace->fp = fp, trace->address = 0, trace->error = 0;
+	if(clock_gettime(CLOCK_MONOTONIC, &trace->time)) return 0;
+	if(fwrite(pool_trace_magic, 1, sizeof pool_trace_magic, fp)
+		!= sizeof pool_trace_magic) { if(!errno) errno = EIO; return 0; }
+	pool_trace_put(trace, (pool_trace_address)size);
+	return !trace->error || (errno = trace->error, 0);
+}
+
+/** Records `op` on `item`, which is ignored for a clear, in `trace`. The
+ first error stops recording, see <fn:pool_trace_end>. */
+static void pool_trace_event(struct pool_trace *const trace,
+	const enum pool_trace_op op, const void *const item) {
+	const pool_trace_address address = (pool_trace_address)item;
+	struct timespec now;
+	pool_trace_address ns, diff;
+	assert(trace && trace->fp && op <= POOL_TRACE_CLEAR);
+	if(trace->error) return;
+	if(clock_gettime(CLOCK_MONOTONIC, &now))
+		{ trace->error = errno; return; }
+	ns = (pool_trace_address)(now.tv_sec - trace->time.tv_sec) * 1000000000u
+		+ (pool_trace_address)now.tv_nsec
+		- (pool_trace_address)trace->time.tv_nsec;
+	trace->time = now;
+	pool_trace_put(trace, ns << 2 | (pool_trace_address)op);
+	if(op == POOL_TRACE_CLEAR) return;
+	diff = address - trace->address, trace->address = address;
+	/* Zig-zag, so nearby in either direction is small. */
+	pool_trace_put(trace, diff >> (sizeof diff * 8 - 1)
+		? ~(diff << 1) : diff << 1);
+}
+
+/** Flushes `trace`; it doesn't close the stream.
+ @return Whether everything was recorded. @throws[fwrite, fflush] */
+static int pool_trace_end(struct pool_trace *const trace) {
+	assert(trace && trace->fp);
+	if(fflush(trace->fp) && !trace->error)
+		trace->error = errno ? errno : EIO;
+	trace->fp = 0;
+	return !trace->error || (errno = trace->error, 0);
+}
+
+/** Starts reading `trace` from `fp`, open for reading; `size` is the size
+ of the items. @return Success. @throws[EILSEQ] Not a trace. */
+static int pool_trace_read(struct pool_trace *const trace, FILE *const fp,
+	size_t *const size) {
+	char magic[sizeof pool_trace_magic];
+	pool_trace_address s;
+	assert(trace && fp && size);
+	trace->fp = fp, trace->address = 0, trace->error = 0;
+	if(fread(magic, 1, sizeof magic, fp) != sizeof magic
+		|| memcmp(magic, pool_trace_magic, sizeof magic)
+		|| !pool_trace_get(trace, &s)) return errno = EILSEQ, 0;
+	*size = (size_t)s;
+	return 1;
+}
+
+/** Reads the next event of `trace` into `event`.
+ @return Success; at the end, false with no error. @throws[EILSEQ] */
+static int pool_trace_next(struct pool_trace *const trace,
+	struct pool_trace_event *const event) {
+	pool_trace_address x, diff;
+	assert(trace && trace->fp && event);
+	if(!pool_trace_get(trace, &x)) goto end;
+	if((x & 3) > POOL_TRACE_CLEAR) { trace->error = EILSEQ; goto end; }
+	event->op = (enum pool_trace_op)(x & 3);
+	event->ns = (unsigned long)(x >> 2);
+	if(event->op == POOL_TRACE_CLEAR) return event->address = 0, 1;
+	if(!pool_trace_get(trace, &diff)) { trace->error = EILSEQ; goto end; }
+	trace->address += diff & 1 ? ~(diff >> 1) : diff >> 1;
+	event->address = trace->address;
+	return 1;
+end:
+	if(trace->error) errno = trace->error;
+	return 0;
+}
+
+static void pool_trace_unused_coda(void);
+static void pool_trace_unused(void) {
+	pool_trace_begin(0, 0, 0); pool_trace_event(0, POOL_TRACE_NEW, 0);
+	pool_trace_end(0); pool_trace_read(0, 0, 0); pool_trace_next(0, 0);
+	pool_trace_unused_coda();
+}
+static void pool_trace_unused_coda(void) { pool_trace_unused(); }
+
+#endif /* idempotent --> */
@@ -0,0 +1,95 @@
+/** Unit test of the pools that have paths for AVX2. With GCC on x86, they are
+ compiled for AVX2 whatever the flags, and run if the processor has it, so
+ the default build reaches them; otherwise, they are what the flags make. */
+
+#if defined(__GNUC__) && !defined(__clang__) \
+	&& (defined(__x86_64__) || defined(__i386__))
+#define AVX2_TARGET
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+#define _DEFAULT_SOURCE /* MAP_ANONYMOUS, madvise for POOL_HUGE and so on */
+#include <stdlib.h> /* rand */
+#include <stdio.h>  /* printf */
+#include <time.h>	/* clock */
+#include <assert.h> /* assert */
+#include "orcish.h"
+#include "avx2.h"
+
+
+static void int_to_string(const int *i, char (*const a)[12])
+	{ sprintf(*a, "%d", *i); }
+static void int_filler(int *const i)
+	{ *i = rand() / (RAND_MAX / 1998 + 1) - 999; }
+/* The slots are compared four at a time in <fn:<PP>slot_idx>. */
+#define POOL_NAME avxinline
+#define POOL_TYPE int
+#define POOL_INLINE_SLOTS
+#define POOL_TEST &int_filler
+#define POOL_EXPECT_TRAIT
+#include "../src/pool.h"
+#define POOL_TO_STRING &int_to_string
+#include "../src/pool.h"
+
+
+struct keyval { int key; char value[12]; };
+static void keyval_filler(struct keyval *const kv)
+	{ kv->key = rand() / (RAND_MAX / 1098 + 1) - 99;
+	orcish(kv->value, sizeof kv->value); }
+static void keyval_key_to_string(const struct keyval *const kv,
+	char (*const a)[12]) { sprintf(*a, "%d_%.7s", kv->key, kv->value); }
+/* Retained slabs come back as secondary slabs in any order. */
+#define POOL_NAME avxretain
+#define POOL_TYPE struct keyval
+#define POOL_INLINE_SLOTS
+#define POOL_RETAIN 4
+#define POOL_RETAIN_DECAY 8
+#define POOL_TEST &keyval_filler
+#define POOL_EXPECT_TRAIT
+#include "../src/pool.h"
+#define POOL_TO_STRING &keyval_key_to_string
+#include "../src/pool.h"
+
+/** Many secondary slabs, so whole vectors of slots are compared, emptied in
+ a random order. */
+static void avx2_remove(void) {
+	struct avxretain_pool pool = avxretain_pool();
+	static struct keyval *kv[20000];
+	const size_t size = sizeof kv / sizeof *kv;
+	size_t i, j, slabs = 0;
+	int r;
+	for(i = 0; i < size; i++) {
+		kv[i] = avxretain_pool_new(&pool), assert(kv[i]);
+		keyval_filler(kv[i]);
+		if(pool.slots.size > slabs) slabs = pool.slots.size;
+	}
+	for(i = size; i; i--) {
+		struct keyval *x;
+		j = (size_t)rand() / (RAND_MAX / i + 1), assert(j < i);
+		x = kv[j], kv[j] = kv[i - 1], kv[i - 1] = x;
+		r = avxretain_pool_remove(&pool, x), assert(r);
+	}
+	assert(pool.slots.size == 1 && !pool.slots.data[0].size);
+	printf("Removed %lu from up to %lu slabs.\n", (unsigned long)size,
+		(unsigned long)slabs);
+	assert(slabs > 5);
+	avxretain_pool_(&pool);
+}
+
+#ifdef AVX2_TARGET
+#pragma GCC pop_options
+#endif
+
+/** Runs the tests, if the processor can. */
+void avx2_test(void) {
+#ifdef AVX2_TARGET
+	__builtin_cpu_init();
+	if(!__builtin_cpu_supports("avx2"))
+		{ printf("AVX2: the processor doesn't have it.\n\n"); return; }
+#endif
+	printf("AVX2:\n");
+	avxinline_pool_test();
+	avxretain_pool_test();
+	avx2_remove();
+	printf("Done AVX2.\n\n");
+}
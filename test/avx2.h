@@ -0,0 +1 @@
+void avx2_test(void);
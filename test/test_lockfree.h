@@ -0,0 +1,135 @@
+/* Intended to be included on `POOL_TEST`. */
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+
+#if defined(QUOTE) || defined(QUOTE_)
+#error QUOTE_? cannot be defined.
+#endif
+#define QUOTE_(name) #name
+#define QUOTE(name) QUOTE_(name)
+
+/* Random allocation and removal in one thread; every item is marked so that
+ another thread having the same item is detected. */
+struct PL_(test_thread) {
+	struct P_(lockfree) *lf;
+	unsigned char mark;
+	unsigned seed;
+	int success;
+	size_t left_size;
+	PP_(type) *left[256];
+};
+
+/** @return Whether all the bytes of `x` are `mark`. */
+static int PL_(test_is)(const PP_(type) *const x, const unsigned char mark) {
+	const unsigned char *b = (const void *)x, *const b_end = b + sizeof *x;
+	while(b < b_end) if(*b++ != mark) return 0;
+	return 1;
+}
+
+/** Runs <tag:<PL>test_thread> `arg`. @return Null. */
+static void *PL_(test_thread)(void *const arg) {
+	struct PL_(test_thread) *const t = arg;
+	const size_t live_max = sizeof t->left / sizeof *t->left;
+	PP_(type) **const live = t->left;
+	unsigned x = t->seed;
+	size_t i, j, n = 0;
+	for(i = 0; i < 200000; i++) {
+		x ^= x << 13, x ^= x >> 17, x ^= x << 5; /* Thread-safe `rand`. */
+		if(n < live_max && (!n || x & 1)) {
+			PP_(type) *const p = P_(lockfree_new)(t->lf);
+			if(!p) goto finally;
+			memset(p, t->mark, sizeof *p);
+			live[n++] = p;
+		} else {
+			j = (x >> 1) % n;
+			if(!PL_(test_is)(live[j], t->mark)) goto finally;
+			memset(live[j], 0, sizeof *live[j]);
+			P_(lockfree_remove)(t->lf, live[j]);
+			live[j] = live[--n];
+		}
+	}
+	t->success = 1;
+finally:
+	/* What's left is for another thread to remove. */
+	t->left_size = n;
+	return 0;
+}
+
+/** @return The number of items on the free stack of `lf`. */
+static size_t PL_(test_free)(struct P_(lockfree) *const lf) {
+	size_t i = POOL_LOAD(&lf->free, POOL_RELAXED) & POOL_HALF_MASK, n = 0;
+	while(i) i = POOL_LOAD(&PL_(at)(lf, i - 1)->link, POOL_RELAXED), n++;
+	return n;
+}
+
+/** The lock-free pool will be tested on stdout. @allow */
+static void P_(lockfree_test)(void) {
+	struct P_(lockfree) lf;
+	struct PL_(test_thread) t[8];
+	pthread_t id[sizeof t / sizeof *t];
+	const size_t t_size = sizeof t / sizeof *t;
+	PP_(type) *a[5 * POOL_LOCKFREE_BASE], *b;
+	const size_t a_size = sizeof a / sizeof *a;
+	size_t i, j, offset;
+	int r;
+
+	printf("<" QUOTE(POOL_NAME) ">lockfree: testing:\n");
+	P_(lockfree)(&lf);
+
+	/* Geometric slabs. */
+	assert(PL_(slab)(0, &offset) == 0 && offset == 0
+		&& PL_(slab)(POOL_LOCKFREE_BASE - 1, &offset) == 0
+		&& offset == POOL_LOCKFREE_BASE - 1
+		&& PL_(slab)(POOL_LOCKFREE_BASE, &offset) == 1 && offset == 0
+		&& PL_(slab)(3 * POOL_LOCKFREE_BASE, &offset) == 2 && offset == 0);
+
+	/* One thread. */
+	for(i = 0; i < a_size; i++) {
+		a[i] = P_(lockfree_new)(&lf), assert(a[i]);
+		memset(a[i], (int)i, sizeof *a[i]);
+	}
+	assert(POOL_LOAD(&lf.size, POOL_RELAXED) == a_size
+		&& POOL_LOAD(&lf.slab[0], POOL_RELAXED)
+		&& POOL_LOAD(&lf.slab[2], POOL_RELAXED)
+		&& !POOL_LOAD(&lf.slab[3], POOL_RELAXED));
+	for(i = 0; i < a_size; i++)
+		assert(PL_(test_is)(a[i], (unsigned char)i));
+	/* A stack, so the last removed is the first new. */
+	P_(lockfree_remove)(&lf, a[3]);
+	P_(lockfree_remove)(&lf, a[a_size - 1]);
+	assert(PL_(test_free)(&lf) == 2);
+	b = P_(lockfree_new)(&lf), assert(b == a[a_size - 1]);
+	b = P_(lockfree_new)(&lf), assert(b == a[3]);
+	assert(!PL_(test_free)(&lf)
+		&& POOL_LOAD(&lf.size, POOL_RELAXED) == a_size);
+	for(i = 0; i < a_size; i++) P_(lockfree_remove)(&lf, a[i]);
+	assert(PL_(test_free)(&lf) == a_size);
+	P_(lockfree_)(&lf);
+	assert(!POOL_LOAD(&lf.size, POOL_RELAXED));
+
+	/* Threads, then the items they left are removed by this one. */
+	printf("Threads: %lu.\n", (unsigned long)t_size);
+	for(i = 0; i < t_size; i++) {
+		t[i].lf = &lf, t[i].mark = (unsigned char)(i + 1);
+		t[i].seed = 2463534242u + (unsigned)i, t[i].success = 0;
+		t[i].left_size = 0;
+		r = !pthread_create(id + i, 0, &PL_(test_thread), t + i), assert(r);
+	}
+	for(i = 0; i < t_size; i++) {
+		r = !pthread_join(id[i], 0), assert(r);
+		assert(t[i].success);
+	}
+	for(i = 0; i < t_size; i++) for(j = 0; j < t[i].left_size; j++) {
+		assert(PL_(test_is)(t[i].left[j], t[i].mark));
+		P_(lockfree_remove)(&lf, t[i].left[j]);
+	}
+	/* Nothing is lost. */
+	assert(PL_(test_free)(&lf) == POOL_LOAD(&lf.size, POOL_RELAXED));
+	P_(lockfree_)(&lf);
+	printf("Done tests of <" QUOTE(POOL_NAME) ">lockfree.\n\n");
+}
+
+#undef QUOTE
+#undef QUOTE_
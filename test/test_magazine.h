@@ -0,0 +1,134 @@
+/* Intended to be included on `POOL_TEST`. */
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(QUOTE) || defined(QUOTE_)
+#error QUOTE_? cannot be defined.
+#endif
+#define QUOTE_(name) #name
+#define QUOTE(name) QUOTE_(name)
+
+/* Random allocation and removal in one thread; every item is marked so that
+ another thread having the same item is detected. */
+struct PM_(test_thread) {
+	struct P_(depot) *depot;
+	unsigned char mark;
+	unsigned seed;
+	int success;
+	size_t left_size;
+	PP_(type) *left[4 * POOL_MAGAZINE];
+};
+
+/** @return Whether all the bytes of `x` are `mark`. */
+static int PM_(test_is)(const PP_(type) *const x, const unsigned char mark) {
+	const unsigned char *b = (const void *)x, *const b_end = b + sizeof *x;
+	while(b < b_end) if(*b++ != mark) return 0;
+	return 1;
+}
+
+/** Runs <tag:<PM>test_thread> `arg`. @return Null. */
+static void *PM_(test_thread)(void *const arg) {
+	struct PM_(test_thread) *const t = arg;
+	struct P_(cache) cache = P_(cache)(t->depot);
+	const size_t live_max = sizeof t->left / sizeof *t->left;
+	PP_(type) **const live = t->left;
+	unsigned x = t->seed;
+	size_t i, j, n = 0;
+	for(i = 0; i < 100000; i++) {
+		x ^= x << 13, x ^= x >> 17, x ^= x << 5; /* Thread-safe `rand`. */
+		if(n < live_max && (!n || x & 1)) {
+			PP_(type) *const p = P_(cache_new)(&cache);
+			if(!p) goto finally;
+			memset(p, t->mark, sizeof *p);
+			live[n++] = p;
+		} else {
+			j = (x >> 1) % n;
+			if(!PM_(test_is)(live[j], t->mark)) goto finally;
+			memset(live[j], 0, sizeof *live[j]);
+			if(!P_(cache_remove)(&cache, live[j])) goto finally;
+			live[j] = live[--n];
+		}
+	}
+	t->success = 1;
+finally:
+	/* What's left is for another thread to remove. */
+	t->left_size = n;
+	P_(cache_)(&cache);
+	return 0;
+}
+
+/** @return Whether `depot` has no items. */
+static int PM_(test_is_empty)(const struct P_(depot) *const depot) {
+	return !depot->full && !depot->empty && (!depot->pool.slots.size
+		|| depot->pool.slots.size == 1 && !depot->pool.slots.data[0].size);
+}
+
+/** The magazines will be tested on stdout. @allow */
+static void P_(magazine_test)(void) {
+	struct P_(depot) depot;
+	struct P_(cache) cache;
+	struct PM_(test_thread) t[4];
+	pthread_t id[sizeof t / sizeof *t];
+	const size_t t_size = sizeof t / sizeof *t;
+	PP_(type) *a[3 * POOL_MAGAZINE];
+	const size_t a_size = sizeof a / sizeof *a;
+	size_t i, j;
+	int r;
+
+	printf("<" QUOTE(POOL_NAME) ">magazine of " QUOTE(POOL_MAGAZINE)
+		": testing:\n");
+	r = P_(depot)(&depot), assert(r);
+
+	/* One thread. The first allocation fills a magazine from the pool. */
+	cache = P_(cache)(&depot);
+	a[0] = P_(cache_new)(&cache), assert(a[0]);
+	assert(depot.pool.slots.size
+		&& depot.pool.slots.data[0].size == POOL_MAGAZINE
+		&& cache.loaded->size == POOL_MAGAZINE - 1 && !cache.previous);
+	for(i = 1; i < a_size; i++) a[i] = P_(cache_new)(&cache), assert(a[i]);
+	for(i = 0; i < a_size; i++)
+		r = P_(cache_remove)(&cache, a[i]), assert(r);
+	/* Two full magazines in the cache and the third in the depot. */
+	assert(cache.loaded->size == POOL_MAGAZINE
+		&& cache.previous->size == POOL_MAGAZINE
+		&& depot.full && !depot.full->next
+		&& depot.full->size == POOL_MAGAZINE);
+	/* Alternating doesn't go to the depot. */
+	for(i = 0; i < 3 * POOL_MAGAZINE; i++) {
+		PP_(type) *const x = P_(cache_new)(&cache);
+		assert(x);
+		r = P_(cache_remove)(&cache, x), assert(r);
+	}
+	assert(depot.full && !depot.full->next);
+	P_(cache_)(&cache);
+	assert(!cache.loaded && !cache.previous);
+	r = P_(depot_reap)(&depot), assert(r);
+	assert(PM_(test_is_empty)(&depot));
+
+	/* Threads, then the items they left are removed by this one. */
+	printf("Threads: %lu.\n", (unsigned long)t_size);
+	for(i = 0; i < t_size; i++) {
+		t[i].depot = &depot, t[i].mark = (unsigned char)(i + 1);
+		t[i].seed = 2463534242u + (unsigned)i, t[i].success = 0;
+		t[i].left_size = 0;
+		r = !pthread_create(id + i, 0, &PM_(test_thread), t + i), assert(r);
+	}
+	for(i = 0; i < t_size; i++) {
+		r = !pthread_join(id[i], 0), assert(r);
+		assert(t[i].success);
+	}
+	cache = P_(cache)(&depot);
+	for(i = 0; i < t_size; i++) for(j = 0; j < t[i].left_size; j++) {
+		assert(PM_(test_is)(t[i].left[j], t[i].mark));
+		r = P_(cache_remove)(&cache, t[i].left[j]), assert(r);
+	}
+	P_(cache_)(&cache);
+	r = P_(depot_reap)(&depot), assert(r);
+	assert(PM_(test_is_empty)(&depot));
+	P_(depot_)(&depot);
+	printf("Done tests of <" QUOTE(POOL_NAME) ">magazine.\n\n");
+}
+
+#undef QUOTE
+#undef QUOTE_
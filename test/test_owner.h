@@ -0,0 +1,96 @@
+/* Intended to be included on `POOL_TEST`. */
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(QUOTE) || defined(QUOTE_)
+#error QUOTE_? cannot be defined.
+#endif
+#define QUOTE_(name) #name
+#define QUOTE(name) QUOTE_(name)
+
+/* Removes every `stride` item of `a`, starting at `mark - 1`, from another
+ thread than the owner. */
+struct PO_(test_thread) {
+	struct P_(owner) *owner;
+	PP_(type) **a;
+	size_t a_size, stride;
+	unsigned char mark;
+	int success;
+};
+
+/** @return Whether all the bytes of `x` are `mark`. */
+static int PO_(test_is)(const PP_(type) *const x, const unsigned char mark) {
+	const unsigned char *b = (const void *)x, *const b_end = b + sizeof *x;
+	while(b < b_end) if(*b++ != mark) return 0;
+	return 1;
+}
+
+/** Runs <tag:<PO>test_thread> `arg`. @return Null. */
+static void *PO_(test_thread)(void *const arg) {
+	struct PO_(test_thread) *const t = arg;
+	size_t i;
+	for(i = t->mark - 1u; i < t->a_size; i += t->stride) {
+		if(!PO_(test_is)(t->a[i], t->mark)
+			|| !P_(owner_remove)(t->owner, t->a[i])) return 0;
+	}
+	t->success = 1;
+	return 0;
+}
+
+/** @return Whether the pool of `owner` has no items. */
+static int PO_(test_is_empty)(const struct P_(owner) *const owner) {
+	return !owner->pool.slots.size || owner->pool.slots.size == 1
+		&& !owner->pool.slots.data[0].size;
+}
+
+/** The owner pool will be tested on stdout. @allow */
+static void P_(owner_test)(void) {
+	struct P_(owner) owner;
+	struct PO_(test_thread) t[4];
+	pthread_t id[sizeof t / sizeof *t];
+	const size_t t_size = sizeof t / sizeof *t;
+	PP_(type) *a[1000], *x;
+	const size_t a_size = sizeof a / sizeof *a;
+	size_t i;
+	int r;
+
+	printf("<" QUOTE(POOL_NAME) ">owner: testing:\n");
+	P_(owner)(&owner);
+
+	/* The owner thread goes straight to the pool. */
+	x = P_(owner_new)(&owner), assert(x);
+	r = P_(owner_remove)(&owner, x), assert(r);
+	assert(!POOL_LOAD(&owner.remote, POOL_RELAXED)
+		&& PO_(test_is_empty)(&owner));
+
+	/* Other threads queue, while the owner allocates and drains. */
+	for(i = 0; i < a_size; i++) {
+		a[i] = P_(owner_new)(&owner), assert(a[i]);
+		memset(a[i], (int)(i % t_size + 1), sizeof *a[i]);
+	}
+	printf("Threads: %lu.\n", (unsigned long)t_size);
+	for(i = 0; i < t_size; i++) {
+		t[i].owner = &owner, t[i].a = a, t[i].a_size = a_size;
+		t[i].stride = t_size, t[i].mark = (unsigned char)(i + 1);
+		t[i].success = 0;
+		r = !pthread_create(id + i, 0, &PO_(test_thread), t + i), assert(r);
+	}
+	for(i = 0; i < 10000; i++) {
+		x = P_(owner_new)(&owner), assert(x);
+		memset(x, 0, sizeof *x);
+		r = P_(owner_remove)(&owner, x), assert(r);
+	}
+	for(i = 0; i < t_size; i++) {
+		r = !pthread_join(id[i], 0), assert(r);
+		assert(t[i].success);
+	}
+	r = P_(owner_drain)(&owner), assert(r);
+	assert(!POOL_LOAD(&owner.remote, POOL_RELAXED)
+		&& PO_(test_is_empty)(&owner));
+	P_(owner_)(&owner);
+	printf("Done tests of <" QUOTE(POOL_NAME) ">owner.\n\n");
+}
+
+#undef QUOTE
+#undef QUOTE_
@@ -0,0 +1,118 @@
+/* Intended to be included on `POOL_TEST`. */
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(QUOTE) || defined(QUOTE_)
+#error QUOTE_? cannot be defined.
+#endif
+#define QUOTE_(name) #name
+#define QUOTE(name) QUOTE_(name)
+
+/* Random allocation and removal in one thread; every item is marked so that
+ another thread having the same item is detected. */
+struct PC_(test_thread) {
+	struct P_(percpu) *pc;
+	unsigned char mark;
+	unsigned seed;
+	int success;
+	size_t left_size;
+	PP_(type) *left[4 * POOL_PERCPU];
+};
+
+/** @return Whether all the bytes of `x` are `mark`. */
+static int PC_(test_is)(const PP_(type) *const x, const unsigned char mark) {
+	const unsigned char *b = (const void *)x, *const b_end = b + sizeof *x;
+	while(b < b_end) if(*b++ != mark) return 0;
+	return 1;
+}
+
+/** Runs <tag:<PC>test_thread> `arg`. @return Null. */
+static void *PC_(test_thread)(void *const arg) {
+	struct PC_(test_thread) *const t = arg;
+	const size_t live_max = sizeof t->left / sizeof *t->left;
+	PP_(type) **const live = t->left;
+	unsigned x = t->seed;
+	size_t i, j, n = 0;
+	for(i = 0; i < 100000; i++) {
+		x ^= x << 13, x ^= x >> 17, x ^= x << 5; /* Thread-safe `rand`. */
+		if(n < live_max && (!n || x & 1)) {
+			PP_(type) *const p = P_(percpu_new)(t->pc);
+			if(!p) goto finally;
+			memset(p, t->mark, sizeof *p);
+			live[n++] = p;
+		} else {
+			j = (x >> 1) % n;
+			if(!PC_(test_is)(live[j], t->mark)) goto finally;
+			memset(live[j], 0, sizeof *live[j]);
+			if(!P_(percpu_remove)(t->pc, live[j])) goto finally;
+			live[j] = live[--n];
+		}
+	}
+	t->success = 1;
+finally:
+	/* What's left is for another thread to remove. */
+	t->left_size = n;
+	return 0;
+}
+
+/** @return Whether `pc` has no items. */
+static int PC_(test_is_empty)(const struct P_(percpu) *const pc) {
+	size_t i;
+	for(i = 0; i < pc->shards; i++) if(pc->shard[i].size) return 0;
+	return !pc->pool.slots.size
+		|| pc->pool.slots.size == 1 && !pc->pool.slots.data[0].size;
+}
+
+/** The per-CPU shards will be tested on stdout. @allow */
+static void P_(percpu_test)(void) {
+	struct P_(percpu) pc;
+	struct PC_(test_thread) t[6];
+	pthread_t id[sizeof t / sizeof *t];
+	const size_t t_size = sizeof t / sizeof *t;
+	PP_(type) *a[2 * POOL_PERCPU];
+	const size_t a_size = sizeof a / sizeof *a;
+	size_t i, j, held;
+	int r;
+
+	printf("<" QUOTE(POOL_NAME) ">percpu of " QUOTE(POOL_PERCPU)
+		": testing on CPU %u:\n", pool_cpu());
+
+	/* One thread; a shard per CPU. */
+	r = P_(percpu)(&pc, 0), assert(r && pc.shards);
+	for(i = 0; i < a_size; i++) a[i] = P_(percpu_new)(&pc), assert(a[i]);
+	for(i = 0; i < a_size; i++)
+		r = P_(percpu_remove)(&pc, a[i]), assert(r);
+	/* The shard overflowed to the pool; what's left is bounded. */
+	for(held = 0, i = 0; i < pc.shards; i++) held += pc.shard[i].size;
+	assert(held && held <= a_size);
+	r = P_(percpu_flush)(&pc), assert(r);
+	assert(PC_(test_is_empty)(&pc));
+	P_(percpu_)(&pc);
+
+	/* Threads on three shards, then the items they left are removed by this
+	 one. */
+	r = P_(percpu)(&pc, 3), assert(r && pc.shards == 3);
+	printf("Threads: %lu.\n", (unsigned long)t_size);
+	for(i = 0; i < t_size; i++) {
+		t[i].pc = &pc, t[i].mark = (unsigned char)(i + 1);
+		t[i].seed = 2463534242u + (unsigned)i, t[i].success = 0;
+		t[i].left_size = 0;
+		r = !pthread_create(id + i, 0, &PC_(test_thread), t + i), assert(r);
+	}
+	for(i = 0; i < t_size; i++) {
+		r = !pthread_join(id[i], 0), assert(r);
+		assert(t[i].success);
+	}
+	for(i = 0; i < t_size; i++) for(j = 0; j < t[i].left_size; j++) {
+		assert(PC_(test_is)(t[i].left[j], t[i].mark));
+		r = P_(percpu_remove)(&pc, t[i].left[j]), assert(r);
+	}
+	r = P_(percpu_flush)(&pc), assert(r);
+	assert(PC_(test_is_empty)(&pc));
+	P_(percpu_)(&pc);
+	printf("Done tests of <" QUOTE(POOL_NAME) ">percpu.\n\n");
+}
+
+#undef QUOTE
+#undef QUOTE_
@@ -1,5 +1,6 @@
 /** Unit test. */
 
+#define _DEFAULT_SOURCE /* MAP_ANONYMOUS, madvise for POOL_HUGE and so on */
 #include <stdlib.h> /* EXIT_ malloc free rand */
 #include <stdio.h>  /* fprintf */
 #include <string.h>	/* strcmp */
@@ -7,6 +8,7 @@
 #include <limits.h>	/* INT_MAX */
 #include <assert.h> /* assert */
 #include "orcish.h"
+#include "avx2.h"
 
 
 #define PARAM(A) A
@@ -88,6 +90,326 @@ static int keyval_value_cmp(const struct Keyval *const a,
 #include "../src/pool.h"
 
 
+/* Slab-zero keeps removed items in a list threaded through them. */
+#define POOL_NAME kvlist
+#define POOL_TYPE struct keyval
+#define POOL_FREE_LIST
+#define POOL_TEST &keyval_filler
+#define POOL_EXPECT_TRAIT
+#include "../src/pool.h"
+#define POOL_TO_STRING &keyval_key_to_string
+#include "../src/pool.h"
+
+
+/* Slab-zero keeps removed items in a bitmap. */
+#define POOL_NAME intbitmap
+#define POOL_TYPE int
+#define POOL_FREE_BITMAP
+#define POOL_TEST &int_filler
+#define POOL_EXPECT_TRAIT
+#include "../src/pool.h"
+#define POOL_TO_STRING &int_to_string
+#include "../src/pool.h"
+
+/* Slabs are aligned and found by address. */
+#define POOL_NAME str4radix
+#define POOL_TYPE struct str4
+#define POOL_RADIX 12
+#define POOL_TEST &str4_filler
+#define POOL_EXPECT_TRAIT
+#include "../src/pool.h"
+#define POOL_TO_STRING &str4_to_string
+#include "../src/pool.h"
+
+/* Slabs are in aligned blocks with a header. */
+#define POOL_NAME kvblock
+#define POOL_TYPE struct keyval
+#define POOL_BLOCK 16
+#define POOL_TEST &keyval_filler
+#define POOL_EXPECT_TRAIT
+#include "../src/pool.h"
+#define POOL_TO_STRING &keyval_key_to_string
+#include "../src/pool.h"
+
+/* Slots are a fixed table in the pool. */
+#define POOL_NAME intinline
+#define POOL_TYPE int
+#define POOL_INLINE_SLOTS
+#define POOL_TEST &int_filler
+#define POOL_EXPECT_TRAIT
+#include "../src/pool.h"
+#define POOL_TO_STRING &int_to_string
+#include "../src/pool.h"
+
+/* Counts the blocks that go through it in the context, if there is one. */
+struct counter { size_t allocs, frees; };
+static void *counter_alloc(void *const context, const size_t size) {
+	struct counter *const count = context;
+	void *const data = malloc(size);
+	if(count && data) count->allocs++;
+	return data;
+}
+static void *counter_realloc(void *const context, void *const data,
+	const size_t size) {
+	struct counter *const count = context;
+	void *const moved = realloc(data, size);
+	if(count && moved && !data) count->allocs++;
+	return moved;
+}
+static void counter_free(void *const context, void *const data) {
+	struct counter *const count = context;
+	if(count && data) count->frees++;
+	free(data);
+}
+/* The slots and the free-heap go through the allocator. */
+#define POOL_NAME kvcount
+#define POOL_TYPE struct keyval
+#define POOL_ALLOC &counter_alloc
+#define POOL_REALLOC &counter_realloc
+#define POOL_FREE &counter_free
+#define POOL_TEST &keyval_filler
+#define POOL_EXPECT_TRAIT
+#include "../src/pool.h"
+#define POOL_TO_STRING &keyval_key_to_string
+#include "../src/pool.h"
+/* The radix table and the free-bitmap go through the allocator. */
+#define POOL_NAME intcount
+#define POOL_TYPE int
+#define POOL_RADIX 12
+#define POOL_FREE_BITMAP
+#define POOL_ALLOC &counter_alloc
+#define POOL_REALLOC &counter_realloc
+#define POOL_FREE &counter_free
+#define POOL_TEST &int_filler
+#define POOL_EXPECT_TRAIT
+#include "../src/pool.h"
+#define POOL_TO_STRING &int_to_string
+#include "../src/pool.h"
+/* Slabs mapped in huge pages. */
+#define POOL_NAME kvhuge
+#define POOL_TYPE struct keyval
+#define POOL_HUGE 21
+#define POOL_TEST &keyval_filler
+#define POOL_EXPECT_TRAIT
+#include "../src/pool.h"
+#define POOL_TO_STRING &keyval_key_to_string
+#include "../src/pool.h"
+/* Every item on a cache-line of it's own. */
+#define POOL_NAME intline
+#define POOL_TYPE int
+#define POOL_CACHELINE_ISOLATE
+#define POOL_TEST &int_filler
+#define POOL_EXPECT_TRAIT
+#include "../src/pool.h"
+#define POOL_TO_STRING &int_to_string
+#include "../src/pool.h"
+/* Over-aligned items in a radix slot map with a free-bitmap. */
+#define POOL_NAME kvalign
+#define POOL_TYPE struct keyval
+#define POOL_ALIGN 32
+#define POOL_RADIX 12
+#define POOL_FREE_BITMAP
+#define POOL_TEST &keyval_filler
+#define POOL_EXPECT_TRAIT
+#include "../src/pool.h"
+#define POOL_TO_STRING &keyval_key_to_string
+#include "../src/pool.h"
+/* Slabs are coloured. */
+#define POOL_NAME kvcolour
+#define POOL_TYPE struct keyval
+#define POOL_COLOUR 4
+#define POOL_TEST &keyval_filler
+#define POOL_EXPECT_TRAIT
+#include "../src/pool.h"
+#define POOL_TO_STRING &keyval_key_to_string
+#include "../src/pool.h"
+/* Coloured with a free-list and lines bigger than a cache-line. */
+#define POOL_NAME kvlinecolour
+#define POOL_TYPE struct keyval
+#define POOL_COLOUR 3
+#define POOL_ALIGN 128
+#define POOL_FREE_LIST
+#define POOL_TEST &keyval_filler
+#define POOL_EXPECT_TRAIT
+#include "../src/pool.h"
+#define POOL_TO_STRING &keyval_key_to_string
+#include "../src/pool.h"
+/* Empty slabs are retained for a while. */
+#define POOL_NAME kvretain
+#define POOL_TYPE struct keyval
+#define POOL_RETAIN 2
+#define POOL_RETAIN_DECAY 8
+#define POOL_TEST &keyval_filler
+#define POOL_EXPECT_TRAIT
+#include "../src/pool.h"
+#define POOL_TO_STRING &keyval_key_to_string
+#include "../src/pool.h"
+/* Retained slabs are limited in bytes and kept in the radix table. */
+#define POOL_NAME intretain
+#define POOL_TYPE int
+#define POOL_RADIX 12
+#define POOL_RETAIN 3
+#define POOL_RETAIN_BYTES 4096
+#define POOL_RETAIN_DECAY 4
+#define POOL_TEST &int_filler
+#define POOL_EXPECT_TRAIT
+#include "../src/pool.h"
+#define POOL_TO_STRING &int_to_string
+#include "../src/pool.h"
+/* Slab zero grows in place in reserved address space. */
+#define POOL_NAME kvreserve
+#define POOL_TYPE struct keyval
+#define POOL_RESERVE 30
+#define POOL_TEST &keyval_filler
+#define POOL_EXPECT_TRAIT
+#include "../src/pool.h"
+#define POOL_TO_STRING &keyval_key_to_string
+#include "../src/pool.h"
+/* The free-bitmap is laid out again as it grows. */
+#define POOL_NAME intreserve
+#define POOL_TYPE int
+#define POOL_RESERVE 30
+#define POOL_FREE_BITMAP
+#define POOL_TEST &int_filler
+#define POOL_EXPECT_TRAIT
+#include "../src/pool.h"
+#define POOL_TO_STRING &int_to_string
+#include "../src/pool.h"
+/* Pages in slab zero with nothing on them are given back. */
+#define POOL_NAME kvpage
+#define POOL_TYPE struct keyval
+#define POOL_PAGE_FREE 12
+#define POOL_TEST &keyval_filler
+#define POOL_EXPECT_TRAIT
+#include "../src/pool.h"
+#define POOL_TO_STRING &keyval_key_to_string
+#include "../src/pool.h"
+/* The same in reserved space, with the free-bitmap. */
+#define POOL_NAME intpage
+#define POOL_TYPE int
+#define POOL_RESERVE 30
+#define POOL_FREE_BITMAP
+#define POOL_PAGE_FREE 12
+#define POOL_TEST &int_filler
+#define POOL_EXPECT_TRAIT
+#include "../src/pool.h"
+#define POOL_TO_STRING &int_to_string
+#include "../src/pool.h"
+/* There is a limit on the memory. */
+#define POOL_NAME kvlimit
+#define POOL_TYPE struct keyval
+#define POOL_LIMIT
+#define POOL_TEST &keyval_filler
+#define POOL_EXPECT_TRAIT
+#include "../src/pool.h"
+#define POOL_TO_STRING &keyval_key_to_string
+#include "../src/pool.h"
+/* The limit is in pages of the reservation. */
+#define POOL_NAME intlimit
+#define POOL_TYPE int
+#define POOL_RESERVE 30
+#define POOL_FREE_BITMAP
+#define POOL_LIMIT
+#define POOL_TEST &int_filler
+#define POOL_EXPECT_TRAIT
+#include "../src/pool.h"
+#define POOL_TO_STRING &int_to_string
+#include "../src/pool.h"
+/* The limit is in huge pages. */
+#define POOL_NAME kvhugelimit
+#define POOL_TYPE struct keyval
+#define POOL_HUGE 21
+#define POOL_LIMIT
+#define POOL_TEST &keyval_filler
+#define POOL_EXPECT_TRAIT
+#include "../src/pool.h"
+#define POOL_TO_STRING &keyval_key_to_string
+#include "../src/pool.h"
+#define POOL_NAME kvstats
+#define POOL_TYPE struct keyval
+#define POOL_STATS
+#define POOL_TEST &keyval_filler
+#define POOL_EXPECT_TRAIT
+#include "../src/pool.h"
+#define POOL_TO_STRING &keyval_key_to_string
+#include "../src/pool.h"
+#define POOL_NAME kvtrace
+#define POOL_TYPE struct keyval
+#define POOL_TRACE
+#define POOL_TEST &keyval_filler
+#define POOL_EXPECT_TRAIT
+#include "../src/pool.h"
+#define POOL_TO_STRING &keyval_key_to_string
+#include "../src/pool.h"
+#define POOL_NAME intsample
+#define POOL_TYPE int
+#define POOL_SAMPLE
+#define POOL_ALIGN 8
+#define POOL_TEST &int_filler
+#define POOL_EXPECT_TRAIT
+#include "../src/pool.h"
+#define POOL_TO_STRING &int_to_string
+#include "../src/pool.h"
+/* Static probes, where there is <sys/sdt.h>; it's in `systemtap-sdt-dev`. */
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<sys/sdt.h>) && __has_include(<elf.h>)
+#define HAS_USDT
+#endif
+#endif
+#ifdef HAS_USDT /* <!-- usdt */
+#include <elf.h>
+#define POOL_NAME kvusdt
+#define POOL_TYPE struct keyval
+#define POOL_USDT
+#define POOL_TEST &keyval_filler
+#define POOL_EXPECT_TRAIT
+#include "../src/pool.h"
+#define POOL_TO_STRING &keyval_key_to_string
+#include "../src/pool.h"
+#endif /* usdt --> */
+
+/* A pool shared by threads through magazines. */
+#define POOL_NAME kvshared
+#define POOL_TYPE struct keyval
+#include "../src/pool.h"
+#define POOL_NAME kvshared
+#define POOL_TYPE struct keyval
+#define POOL_MAGAZINE 16
+#define POOL_TEST
+#include "../src/magazine.h"
+
+/* A pool that threads share without a lock. */
+#define POOL_NAME kvlockfree
+#define POOL_TYPE struct keyval
+#include "../src/pool.h"
+#define POOL_NAME kvlockfree
+#define POOL_TYPE struct keyval
+#define POOL_LOCKFREE_BASE 4
+#define POOL_TEST
+#include "../src/lockfree.h"
+
+/* A pool that one thread allocates and any thread removes. */
+#define POOL_NAME kvowner
+#define POOL_TYPE struct keyval
+#include "../src/pool.h"
+#define POOL_NAME kvowner
+#define POOL_TYPE struct keyval
+#define POOL_OWNER_BATCH 16
+#define POOL_TEST
+#include "../src/owner.h"
+
+/* A pool with a shard for each CPU in front; it counts, with threads. */
+#define POOL_NAME kvpercpu
+#define POOL_TYPE struct keyval
+#define POOL_STATS
+#include "../src/pool.h"
+#define POOL_NAME kvpercpu
+#define POOL_TYPE struct keyval
+#define POOL_PERCPU 8
+#define POOL_TEST
+#include "../src/percpu.h"
+
+
 /** For paper. */
 static void special(void) {
 	struct keyval_pool kvp = keyval_pool();
@@ -111,6 +433,93 @@ finally:
 	keyval_pool_(&kvp);
 }
 
+/** All the memory of pools with an allocator goes through it's context. */
+static void allocator(void) {
+	struct counter count = { 0, 0 };
+	struct kvcount_pool a = kvcount_pool_context(&count);
+	struct intcount_pool b = intcount_pool_context(&count);
+	struct keyval *kv[1000];
+	int *n[sizeof kv / sizeof *kv];
+	const size_t size = sizeof kv / sizeof *kv;
+	size_t i;
+	int r;
+	printf("Allocator:\n");
+	for(i = 0; i < size; i++) {
+		kv[i] = kvcount_pool_new(&a), assert(kv[i]);
+		n[i] = intcount_pool_new(&b), assert(n[i]);
+	}
+	/* Holes in slab zero. */
+	for(i = 0; i < size; i += 3) {
+		r = kvcount_pool_remove(&a, kv[i]), assert(r);
+		r = intcount_pool_remove(&b, n[i]), assert(r);
+	}
+	assert(count.allocs > 2 && count.frees < count.allocs);
+	kvcount_pool_(&a);
+	intcount_pool_(&b);
+	assert(a.context == &count && b.context == &count
+		&& count.allocs == count.frees);
+	printf("%lu allocations, all freed.\n\n", (unsigned long)count.allocs);
+}
+
+#ifdef HAS_USDT /* <!-- usdt */
+/** The probes of `kvusdt` are notes in the `.note.stapsdt` section of this
+ executable, where `perf` and `bpftrace` find them. */
+static void usdt(void) {
+	const char *const want[] = { "slab_new", "slab_recycle", "slab_free",
+		"free0_grow", "tail_shrink" };
+	unsigned found = 0;
+	FILE *fp = 0;
+	Elf64_Ehdr eh;
+	Elf64_Shdr sh, names;
+	char *section = 0, *n, *end, name[sizeof ".note.stapsdt"];
+	size_t i;
+	int r;
+	kvusdt_pool_test();
+	r = !!(fp = fopen("/proc/self/exe", "rb")), assert(r);
+	r = fread(&eh, sizeof eh, 1, fp) == 1
+		&& !memcmp(eh.e_ident, ELFMAG, SELFMAG)
+		&& eh.e_ident[EI_CLASS] == ELFCLASS64, assert(r);
+	r = !fseek(fp, (long)(eh.e_shoff + eh.e_shstrndx * sizeof sh), SEEK_SET)
+		&& fread(&names, sizeof names, 1, fp) == 1, assert(r);
+	for(i = 0; i < eh.e_shnum; i++) {
+		r = !fseek(fp, (long)(eh.e_shoff + i * sizeof sh), SEEK_SET)
+			&& fread(&sh, sizeof sh, 1, fp) == 1
+			&& !fseek(fp, (long)(names.sh_offset + sh.sh_name), SEEK_SET),
+			assert(r);
+		if(sh.sh_type != SHT_NOTE || !fgets(name, sizeof name, fp)
+			|| strcmp(name, ".note.stapsdt")) continue;
+		r = !!(section = malloc(sh.sh_size))
+			&& !fseek(fp, (long)sh.sh_offset, SEEK_SET)
+			&& fread(section, sh.sh_size, 1, fp) == 1, assert(r);
+		break;
+	}
+	assert(section);
+	/* Each note is a header, "stapsdt", three addresses, and the provider,
+	 probe, and arguments, "size@operand", as strings, padded to four. */
+	for(n = section, end = n + sh.sh_size; n + sizeof(Elf64_Nhdr) <= end; ) {
+		const Elf64_Nhdr *const nh = (const Elf64_Nhdr *)(void *)n;
+		const char *const owner = n + sizeof *nh,
+			*const desc = owner + ((nh->n_namesz + 3) & ~3u),
+			*const provider = desc + 3 * 8,
+			*const probe = provider + strlen(provider) + 1,
+			*const args = probe + strlen(probe) + 1;
+		if(nh->n_type == 3 && !strcmp(owner, "stapsdt")
+			&& !strcmp(provider, "pool")) {
+			/* The name is a pointer, not the bytes of an array. */
+			assert(!strncmp(args, "8@", 2));
+			for(i = 0; i < sizeof want / sizeof *want; i++)
+				if(!strcmp(probe, want[i])) found |= 1u << i;
+		}
+		n = (char *)desc + ((nh->n_descsz + 3) & ~3u);
+	}
+	free(section);
+	fclose(fp);
+	assert(found == (1u << sizeof want / sizeof *want) - 1);
+	printf("Probes: all %lu in .note.stapsdt.\n\n",
+		(unsigned long)(sizeof want / sizeof *want));
+}
+#endif /* usdt --> */
+
 /** Entry point.
  @return Either EXIT_SUCCESS or EXIT_FAILURE. */
 int main(void) {
@@ -121,6 +530,48 @@ int main(void) {
 	str4_pool_test();
 	int_pool_test();
 	keyval_pool_test();
+	kvlist_pool_test();
+	intbitmap_pool_test();
+	str4radix_pool_test();
+	kvblock_pool_test();
+	intinline_pool_test();
+	avx2_test();
+	kvcount_pool_test();
+	intcount_pool_test();
+	allocator();
+	intline_pool_test();
+	kvalign_pool_test();
+	kvcolour_pool_test();
+	kvlinecolour_pool_test();
+	kvretain_pool_test();
+	intretain_pool_test();
+	kvhuge_pool_test();
+	kvreserve_pool_test();
+	intreserve_pool_test();
+	kvpage_pool_test();
+	intpage_pool_test();
+	kvlimit_pool_test();
+	intlimit_pool_test();
+	kvhugelimit_pool_test();
+	kvstats_pool_test();
+	kvtrace_pool_test();
+	intsample_pool_test();
+#ifdef HAS_USDT
+	usdt();
+#else
+	printf("Probes: skipped, without <sys/sdt.h> on Linux.\n\n");
+#endif
+	kvshared_magazine_test();
+	kvlockfree_lockfree_test();
+	kvowner_owner_test();
+	kvpercpu_percpu_test();
+	{ /* Everything removed was new. */
+		struct kvpercpu_pool_counters c;
+		kvpercpu_pool_counters(&c);
+		assert(c.remove0 + c.remove_slab <= c.new_free0 + c.new_tail
+			&& c.grow <= c.room);
+		printf("Percpu: "), kvpercpu_pool_counters_print(stdout);
+	}
 	special();
 	printf("Test success.\n\n");
 
@@ -15,14 +15,40 @@ typedef void (*PP_(action_fn))(PP_(type) *);
 /** `POOL_TEST` must be a function that implements <typedef:<PP>action_fn>. */
 static const PP_(action_fn) PP_(filler) = (POOL_TEST);
 
+/* Iterates over the removed indices in slab-zero, in heap, list, or index
+ order. */
+struct PP_(free0_it) { const struct P_(pool) *pool; size_t i, idx; };
+/** @return Before the first removed index in `pool`. */
+static struct PP_(free0_it) PP_(free0_it)(const struct P_(pool) *const pool)
+	{ struct PP_(free0_it) it; it.pool = pool, it.i = 0, it.idx = 0;
+	return it; }
+/** Sets the next removed index in `it`. @return Whether there was one. */
+static int PP_(free0_next)(struct PP_(free0_it) *const it) {
+	assert(it && it->pool);
+	if(it->i >= PP_(free0_size)(it->pool)) return 0;
+#if defined(POOL_FREE_LIST)
+	if(!it->i) it->idx = it->pool->free0.head;
+	else memcpy(&it->idx, PP_(at)(it->pool->slots.data[0].slab, it->idx),
+		sizeof it->idx);
+#elif defined(POOL_FREE_BITMAP)
+	if(it->i) it->idx++;
+	while(!PP_(free0_is)(it->pool, it->idx)) it->idx++;
+#else
+	it->idx = it->pool->free0._.data[it->i];
+#endif
+	it->i++;
+	return 1;
+}
+
 /** Graphs `pool` output to `fn`. */
 static void PP_(graph)(const struct P_(pool) *const pool,
 	const char *const fn) {
 	FILE *fp;
 	char str[12];
 	size_t i, j;
-	struct PP_(slot) *slot;
+	const struct PP_(slot) *slot;
 	PP_(type) *slab;
+	struct PP_(free0_it) it;
 
 	assert(pool && fn);
 	if(!(fp = fopen(fn, "w"))) { perror(fn); return; }
@@ -31,12 +57,18 @@ static void PP_(graph)(const struct P_(pool) *const pool,
 		"\tgraph [rankdir=LR, truecolor=true, bgcolor=transparent,"
 		" fontface=modern];\n"
 		"\tnode [shape=box, style=filled, fillcolor=\"Gray95\"];\n");
-	if(!pool->free0._.size) goto no_free0;
-	for(i = 0; i < pool->free0._.size; i++) {
+	if(!PP_(free0_size)(pool)) goto no_free0;
+	for(it = PP_(free0_it)(pool); PP_(free0_next)(&it); ) {
+		i = it.i - 1;
 		fprintf(fp, "\tfree0_%lu [label=<<FONT COLOR=\"Gray75\">%lu</FONT>>,"
-			" shape=circle];\n", i, pool->free0._.data[i]);
+			" shape=circle];\n", (unsigned long)i, (unsigned long)it.idx);
+#ifdef POOL_FREE_CONSTANT
+		if(i) fprintf(fp, "\tfree0_%lu -> free0_%lu [dir=back];\n",
+			(unsigned long)i, (unsigned long)(i - 1));
+#else
 		if(i) fprintf(fp, "\tfree0_%lu -> free0_%lu [dir=back];\n",
-			i, (unsigned long)((i - 1) / 2));
+			(unsigned long)i, (unsigned long)((i - 1) / 2));
+#endif
 	}
 	fprintf(fp, "\t{rank=same; pool; free0_0; }\n"
 		"\tpool:free -> free0_0;\n");
@@ -67,10 +99,18 @@ no_free0:
 		"\t</TR>\n"
 		"</TABLE>>];\n",
 		(unsigned long)pool->slots.size,
+#ifdef POOL_INLINE_SLOTS
+		(unsigned long)POOL_SLOT_MAX,
+#else
 		(unsigned long)pool->slots.capacity,
-		(unsigned long)pool->free0._.size,
+#endif
+		(unsigned long)PP_(free0_size)(pool),
+#ifdef POOL_FREE_CONSTANT
+		(unsigned long)0);
+#else
 		(unsigned long)pool->free0._.capacity);
-	if(!pool->slots.data) goto no_slots;
+#endif
+	if(!pool->slots.size) goto no_slots;
 	fprintf(fp, "\tpool:slots -> slots;\n"
 		"\tslots [label = <\n"
 		"<TABLE BORDER=\"0\">\n"
@@ -112,11 +152,8 @@ no_free0:
 		/* Primary buffer: print rows. */
 		if(!(bmp = calloc(slot->size, sizeof *bmp)))
 			{ perror("temp bitmap"); assert(0); exit(EXIT_FAILURE); };
-		for(j = 0; j < pool->free0._.size; j++) {
-			size_t *f0p = pool->free0._.data + j;
-			assert(f0p && *f0p < slot->size);
-			bmp[*f0p] = 1;
-		}
+		for(it = PP_(free0_it)(pool); PP_(free0_next)(&it); )
+			assert(it.idx < slot->size), bmp[it.idx] = 1;
 		for(j = 0; j < slot->size; j++) {
 			const char *const bgc = j & 1 ? "" : " BGCOLOR=\"Gray90\"";
 			fprintf(fp, "\t<TR>\n"
@@ -127,7 +164,7 @@ no_free0:
 					"<FONT COLOR=\"Gray75\">deleted"
 					"</FONT></TD>\n", bgc);
 			} else {
-				PP_(to_string)(slab + j, &str);
+				PP_(to_string)(PP_(at)(slab, j), &str);
 				fprintf(fp, "\t\t<TD ALIGN=\"LEFT\"%s>%s</TD>\n", bgc, str);
 			}
 			fprintf(fp, "\t</TR>\n");
@@ -151,10 +188,14 @@ no_slots:
 
 /** Crashes if `pool` is not in a valid state. */
 static void PP_(valid_state)(const struct P_(pool) *const pool) {
+	struct PP_(free0_it) it;
 	size_t i;
 	if(!pool) return;
 	/* If there's no capacity, there's no slots. */
 	if(!pool->capacity0) assert(!pool->slots.size);
+	/* The watermarks are never below. */
+	assert(pool->size <= pool->peak_size
+		&& PP_(footprint)(pool) <= pool->peak_bytes);
 	/* Every slot up to size is active. */
 	for(i = 0; i < pool->slots.size; i++) {
 		assert(pool->slots.data[i].slab);
@@ -162,16 +203,135 @@ static void PP_(valid_state)(const struct P_(pool) *const pool) {
 	}
 	if(!pool->slots.size) {
 		/* There are no free0 without slots. */
-		assert(!pool->free0._.size);
+		assert(!PP_(free0_size)(pool));
 	} else {
 		/* size[0] <= capacity0 */
 		assert(pool->slots.data[0].size <= pool->capacity0);
+		/* The top is not removed, unless it's empty. */
+		assert(!PP_(free0_size)(pool)
+			|| PP_(free0_size)(pool) < pool->slots.data[0].size);
 		/* The free-heap indices are strictly less than the size. */
-		for(i = 0; i < pool->free0._.size; i++)
-			assert(pool->free0._.data[i] < pool->slots.data[0].size);
+		for(it = PP_(free0_it)(pool); PP_(free0_next)(&it); )
+			assert(it.idx < pool->slots.data[0].size);
+	}
+#ifdef POOL_SLOT_MAP
+	/* Slabs are aligned and the map agrees with the search. */
+	for(i = 0; i < pool->slots.size; i++) {
+		const PP_(type) *const slab = pool->slots.data[i].slab;
+		const size_t capacity = PP_(slab_capacity)(slab);
+#ifdef POOL_RADIX
+		assert(!(POOL_ADDRESS(slab) & POOL_RADIX_MASK(POOL_RADIX)));
+#else
+		assert((const void *)(PP_(block_head)(slab) + 1) == slab);
+#endif
+		assert((i || capacity == pool->capacity0)
+			&& PP_(slot_idx)(pool, slab) == i
+			&& PP_(slot_idx)(pool, PP_(at)(slab, capacity - 1)) == i
+			&& (!i || PP_(upper)(&pool->slots, slab) == i + 1));
+	}
+#endif
+#ifdef POOL_HUGE
+	/* Slabs are at the start of their huge pages, which they fill. */
+	for(i = 0; i < pool->slots.size; i++) {
+		const PP_(type) *const slab = pool->slots.data[i].slab;
+		const struct pool_huge_head *const head = PP_(huge_head)(slab);
+		const size_t committed = PP_(huge_bytes)(head->capacity);
+		assert(!(POOL_ADDRESS(head) & POOL_HUGE_MASK)
+			&& !(head->bytes & POOL_HUGE_MASK) && committed <= head->bytes
+			&& sizeof *head + (head->capacity + 1) * sizeof *slab > committed
+			&& head->capacity == pool->slots.data[i].capacity
+			&& (i || head->capacity == pool->capacity0));
+	}
+#endif
+#ifdef POOL_ALIGNMENT
+	/* Slabs, and so every item in them, are aligned. */
+	for(i = 0; i < pool->slots.size; i++)
+		assert(!(POOL_ADDRESS(pool->slots.data[i].slab)
+		& (POOL_ALIGNMENT - 1)));
+#endif
+#ifdef POOL_COLOUR
+	/* Slabs are a whole number of lines from their colour. */
+	for(i = 0; i < pool->slots.size; i++) {
+		const PP_(type) *const slab = pool->slots.data[i].slab;
+		const size_t colour = PP_(slab_head)(slab).colour;
+		assert(colour < POOL_COLOUR && !((POOL_ADDRESS(slab)
+			- colour * POOL_COLOUR_LINE) & (POOL_COLOUR_LINE - 1)));
+	}
+#endif
+#ifdef POOL_RETAIN
+	/* Retained slabs are oldest first, not in use, and within the limits. */
+	{
+		size_t bytes = 0, j;
+		assert(pool->retained_size <= POOL_RETAIN);
+		for(i = 0; i < pool->retained_size; i++) {
+			const struct PP_(retained) *const r = pool->retained + i;
+			assert(r->slab && r->capacity && r->epoch <= pool->epoch
+				&& pool->epoch - r->epoch <= POOL_RETAIN_DECAY
+				&& (!i || r[-1].epoch <= r->epoch));
+			bytes += r->capacity * POOL_STRIDE;
+			for(j = 0; j < pool->slots.size; j++)
+				assert(pool->slots.data[j].slab != r->slab);
+		}
+		assert(bytes == pool->retained_bytes && bytes <= POOL_RETAIN_BYTES);
+	}
+#endif
+	/* Every slot knows it's capacity, and the counts are their sums. */
+	{
+		size_t size = 0, capacity = 0;
+		if(pool->slots.size) {
+			assert(pool->slots.data[0].capacity == pool->capacity0);
+			size = pool->slots.data[0].size - PP_(free0_size)(pool);
+			capacity = pool->capacity0;
+		}
+		for(i = 1; i < pool->slots.size; i++) {
+			size += pool->slots.data[i].size;
+			capacity += pool->slots.data[i].capacity;
+		}
+		assert(size == pool->size && capacity == pool->capacity
+			&& size <= pool->peak_size);
+	}
+#if defined(POOL_SLOT_MAP) || defined(POOL_HUGE)
+	for(i = 0; i < pool->slots.size; i++) assert(pool->slots.data[i].capacity
+		== PP_(slab_capacity)(pool->slots.data[i].slab));
+#endif
+#ifdef POOL_RESERVE
+	/* Only slab zero, committed within the reservation. */
+	assert(pool->slots.size <= 1 && pool->capacity0
+		<= ((size_t)1 << POOL_RESERVE) / POOL_STRIDE);
+#endif
+#ifdef POOL_PAGE_FREE
+	/* Every page of slab zero counts the live items that touch it. */
+	if(pool->slots.size) {
+		const size_t o = PP_(page_offset)(pool),
+			size0 = pool->slots.data[0].size;
+		size_t *const live = calloc(pool->page_capacity + 1, sizeof *live), p;
+		char *const removed = calloc(size0 + 1, 1);
+		assert(live && removed
+			&& PP_(pages)(pool->capacity0) <= pool->page_capacity);
+		for(it = PP_(free0_it)(pool); PP_(free0_next)(&it); )
+			removed[it.idx] = 1;
+		for(i = 0; i < size0; i++) if(!removed[i])
+			for(p = (o + i * POOL_STRIDE) >> POOL_PAGE_FREE;
+			p <= (o + (i + 1) * POOL_STRIDE - 1) >> POOL_PAGE_FREE; p++)
+			live[p]++;
+		for(p = 0; p < pool->page_capacity; p++)
+			assert(live[p] == pool->page_live[p]);
+		free(live), free(removed);
+	}
+#endif
+#ifdef POOL_INLINE_SLOTS
+	/* Counting agrees with the search. */
+	assert(pool->slots.size <= POOL_SLOT_MAX);
+	for(i = 1; i < pool->slots.size; i++) {
+		const PP_(type) *const slab = pool->slots.data[i].slab;
+		assert(PP_(slot_idx)(pool, slab) == i
+			&& PP_(upper)(&pool->slots, slab) == i + 1);
 	}
+#endif
 }
 
+#if !defined(POOL_HUGE) && !defined(POOL_RESERVE) /* <!-- small: these
+ depend on the capacities and number of slabs. */
 static void PP_(test_states)(void) {
 	struct P_(pool) pool = P_(pool)();
 	PP_(type) *t, *slab;
@@ -194,7 +354,7 @@ static void PP_(test_states)(void) {
 	PP_(graph)(&pool, "graph/" QUOTE(POOL_NAME) "-02-one.gv");
 
 	printf("Remove.\n");
-	r = P_(pool_remove)(&pool, pool.slots.data[0].slab + 0), assert(r),
+	r = P_(pool_remove)(&pool, PP_(at)(pool.slots.data[0].slab, 0)), assert(r),
 		PP_(valid_state)(&pool);
 	PP_(graph)(&pool, "graph/" QUOTE(POOL_NAME) "-03-remove.gv");
 
@@ -221,19 +381,19 @@ static void PP_(test_states)(void) {
 	assert(pool.slots.data[0].size == 1);
 	printf("%s is %u, %s is %u.\n", orcify(pool.slots.data[1].slab), conf,
 		orcify(pool.slots.data[2].slab), !conf);
-	t = pool.slots.data[!conf + 1].slab + 0, PP_(to_string)(t, &z);
+	t = PP_(at)(pool.slots.data[!conf + 1].slab, 0), PP_(to_string)(t, &z);
 	printf("Removing index-zero %s from slab %u %s.\n", z, !conf + 1,
 		orcify(pool.slots.data[!conf + 1].slab));
 	P_(pool_remove)(&pool, t), PP_(valid_state)(&pool);
-	t = pool.slots.data[0].slab + 0, PP_(to_string)(t, &z);
+	t = PP_(at)(pool.slots.data[0].slab, 0), PP_(to_string)(t, &z);
 	printf("Removing index-zero %s from slab %u %s.\n", z, 0,
 		orcify(pool.slots.data[0].slab));
-	P_(pool_remove)(&pool, pool.slots.data[0].slab + 0);
+	P_(pool_remove)(&pool, PP_(at)(pool.slots.data[0].slab, 0));
 	PP_(valid_state)(&pool);
 	assert(pool.slots.data[conf + 1].size == size[0]);
 	slab = pool.slots.data[conf + 1].slab;
 	printf("Removing all in slab %s.\n", orcify(slab));
-	for(i = 0; i < size[0]; i++) P_(pool_remove)(&pool, slab + i);
+	for(i = 0; i < size[0]; i++) P_(pool_remove)(&pool, PP_(at)(slab, i));
 	PP_(valid_state)(&pool);
 	PP_(graph)(&pool, "graph/" QUOTE(POOL_NAME) "-08-remove-slab.gv");
 	assert(pool.slots.size == 2);
@@ -263,25 +423,26 @@ static void PP_(test_states)(void) {
 			bits |= rnd_bit;
 		}
 		for(i = 0; i < size[2]; i++) if(bits & (1 << i))
-			P_(pool_remove)(&pool, pool.slots.data[0].slab + i);
+			P_(pool_remove)(&pool, PP_(at)(pool.slots.data[0].slab, i));
 		i = n0;
 	}
 	PP_(graph)(&pool, "graph/" QUOTE(POOL_NAME) "-10-remove.gv");
 	assert(pool.slots.size == 1 && pool.slots.data[0].size == size[2]
-		&& pool.capacity0 == size[2] && pool.free0._.size == i);
+		&& pool.capacity0 == size[2] && PP_(free0_size)(&pool) == i);
 
 	/* Add at random to an already removed. */
 	while(i) t = P_(pool_new)(&pool), assert(t),
 		PP_(filler)(t), PP_(valid_state)(&pool), i--;
 	PP_(graph)(&pool, "graph/" QUOTE(POOL_NAME) "-11-replace.gv");
 	assert(pool.slots.size == 1 && pool.slots.data[0].size == size[2]
-		&& pool.capacity0 == size[2] && pool.free0._.size == 0);
+		&& pool.capacity0 == size[2] && PP_(free0_size)(&pool) == 0);
 
 	printf("Destructor:\n");
 	P_(pool_)(&pool);
 	PP_(valid_state)(&pool);
 	printf("Done basic tests.\n\n");
 }
+#endif /* small --> */
 
 /* #define ARRAY_NAME PP_(test)
 #define ARRAY_TYPE PP_(type) *
@@ -342,6 +503,743 @@ static void PP_(test_random)(void) {
 	P_(pool_)(&pool);
 }
 
+static void PP_(test_bulk)(void) {
+	struct P_(pool) pool = P_(pool)();
+	PP_(type) *run, *ptrs[20];
+	const size_t run_size = 30, ptrs_size = sizeof ptrs / sizeof *ptrs;
+	size_t i;
+	int r;
+
+	printf("Bulk allocation.\n");
+	errno = 0;
+	run = P_(pool_new_n)(&pool, 0), assert(!run && !errno);
+	r = P_(pool_buffer)(&pool, run_size + ptrs_size), assert(r);
+	run = P_(pool_new_n)(&pool, run_size), assert(run);
+	for(i = 0; i < run_size; i++) PP_(filler)(PP_(at)(run, i));
+	PP_(valid_state)(&pool);
+	assert(pool.slots.size == 1 && pool.slots.data[0].size == run_size
+		&& run == pool.slots.data[0].slab);
+	/* Holes in slab zero are filled first by the pointer version. */
+	for(i = 0; i < run_size; i += 3)
+		r = P_(pool_remove)(&pool, PP_(at)(run, i)), assert(r);
+	PP_(valid_state)(&pool);
+	assert(PP_(free0_size)(&pool) == run_size / 3);
+	r = P_(pool_new_ptrs)(&pool, ptrs, ptrs_size), assert(r);
+	for(i = 0; i < ptrs_size; i++) PP_(filler)(ptrs[i]);
+	PP_(valid_state)(&pool);
+	assert(!PP_(free0_size)(&pool));
+	for(i = 0; i < run_size / 3; i++) assert(ptrs[i] >= run
+		&& ptrs[i] < PP_(at)(run, run_size) && !(PP_(index)(run, ptrs[i]) % 3));
+#ifdef POOL_FREE_BITMAP
+	/* The lowest removed index is always taken first. */
+	for(i = 1; i < run_size / 3; i++) assert(ptrs[i - 1] < ptrs[i]);
+#endif
+	r = P_(pool_remove)(&pool, PP_(at)(run, 1)), assert(r);
+	assert(PP_(free0_size)(&pool) == 1);
+#ifdef POOL_RESERVE /* <!-- reserve */
+	/* A run that doesn't fit grows slab zero in place, keeping the holes. */
+	{
+		PP_(type) *const slab0 = pool.slots.data[0].slab;
+		const size_t size0 = pool.slots.data[0].size;
+		run = P_(pool_new_n)(&pool, pool.capacity0 + 1), assert(run);
+		PP_(valid_state)(&pool);
+		assert(pool.slots.size == 1 && PP_(free0_size)(&pool) == 1
+			&& pool.slots.data[0].slab == slab0 && run == PP_(at)(slab0, size0));
+	}
+#else /* reserve --><!-- slabs */
+	/* A run that doesn't fit evicts slab zero, even with a free-heap. */
+	run = P_(pool_new_n)(&pool, pool.capacity0 + 1), assert(run);
+	PP_(valid_state)(&pool);
+	assert(pool.slots.size == 2 && !PP_(free0_size)(&pool)
+		&& run == pool.slots.data[0].slab
+		&& pool.slots.data[1].size == run_size + ptrs_size - run_size / 3 - 1);
+#endif /* slabs --> */
+	/* Everything is individually removable. */
+	for(i = 0; i < ptrs_size; i++) P_(pool_remove)(&pool, ptrs[i]);
+	PP_(valid_state)(&pool);
+	P_(pool_)(&pool);
+	PP_(valid_state)(&pool);
+	printf("Done bulk tests.\n\n");
+}
+
+#if !defined(POOL_HUGE) && !defined(POOL_RESERVE) /* <!-- small */
+static void PP_(test_remove_n)(void) {
+	struct P_(pool) pool = P_(pool)();
+	PP_(type) *ptrs[100], *temp, *run;
+	const size_t ptrs_size = sizeof ptrs / sizeof *ptrs;
+	size_t i, j, n;
+	int r;
+
+	printf("Batched remove.\n");
+	for(i = 0; i < ptrs_size; i++)
+		ptrs[i] = P_(pool_new)(&pool), assert(ptrs[i]), PP_(filler)(ptrs[i]);
+	assert(pool.slots.size > 2);
+	PP_(graph)(&pool, "graph/" QUOTE(POOL_NAME) "-12-remove-n-before.gv");
+	r = P_(pool_remove_n)(&pool, ptrs, 0), assert(r);
+	for(i = ptrs_size - 1; i; i--) { /* Shuffle. */
+		j = (unsigned)rand() / (RAND_MAX / (i + 1) + 1);
+		temp = ptrs[i], ptrs[i] = ptrs[j], ptrs[j] = temp;
+	}
+	/* Leave some in slab zero, and one in a secondary slab. */
+	for(i = 0; i < ptrs_size - 1; i++)
+		if(PP_(slot_idx)(&pool, ptrs[i])) break;
+	assert(i < ptrs_size - 1);
+	temp = ptrs[i], ptrs[i] = ptrs[ptrs_size - 1], ptrs[ptrs_size - 1] = temp;
+	n = (ptrs_size - 1) / 2;
+	r = P_(pool_remove_n)(&pool, ptrs, n), assert(r);
+	PP_(valid_state)(&pool);
+	PP_(graph)(&pool, "graph/" QUOTE(POOL_NAME) "-13-remove-n-half.gv");
+	assert(pool.slots.size >= 2);
+	r = P_(pool_remove_n)(&pool, ptrs + n, ptrs_size - 1 - n), assert(r);
+	PP_(valid_state)(&pool);
+	assert(pool.slots.size == 2 && pool.slots.data[1].size == 1
+		&& !pool.slots.data[0].size && !PP_(free0_size)(&pool));
+	r = P_(pool_remove_n)(&pool, ptrs + ptrs_size - 1, 1), assert(r);
+	PP_(valid_state)(&pool);
+	assert(pool.slots.size == 1);
+	/* Sparse removal in a big slab zero sorts instead of a bitmap. */
+	r = P_(pool_buffer)(&pool, 4000), assert(r);
+	run = P_(pool_new_n)(&pool, 4000), assert(run);
+	ptrs[0] = PP_(at)(run, 3999), ptrs[1] = PP_(at)(run, 10);
+	ptrs[2] = PP_(at)(run, 3998);
+	r = P_(pool_remove_n)(&pool, ptrs, 3), assert(r);
+	PP_(valid_state)(&pool);
+	assert(pool.slots.data[0].size == 3998 && PP_(free0_size)(&pool) == 1);
+	ptrs[0] = PP_(at)(run, 3997);
+	r = P_(pool_remove_n)(&pool, ptrs, 1), assert(r);
+	assert(pool.slots.data[0].size == 3997 && PP_(free0_size)(&pool) == 1);
+	P_(pool_)(&pool);
+	printf("Done batched remove tests.\n\n");
+}
+#endif /* small --> */
+
+#ifdef POOL_FREE_BITMAP /* <!-- bitmap */
+static void PP_(test_bitmap)(void) {
+	struct P_(pool) pool = P_(pool)();
+	/* Spread over many words and more than one summary word. */
+	const size_t size = 300000, rm[] = { 299000, 270000, 5, 4097 },
+		rm_size = sizeof rm / sizeof *rm;
+	PP_(type) *run, *t;
+	size_t i;
+	int r;
+
+	printf("Free-bitmap.\n");
+	run = P_(pool_new_n)(&pool, size), assert(run);
+	for(i = 0; i < rm_size; i++)
+		r = P_(pool_remove)(&pool, PP_(at)(run, rm[i])), assert(r);
+	PP_(valid_state)(&pool);
+	assert(PP_(free0_size)(&pool) == rm_size);
+	t = P_(pool_new)(&pool), assert(t == PP_(at)(run, 5));
+	t = P_(pool_new)(&pool), assert(t == PP_(at)(run, 4097));
+	t = P_(pool_new)(&pool), assert(t == PP_(at)(run, 270000));
+	r = P_(pool_remove)(&pool, PP_(at)(run, 3)), assert(r);
+	t = P_(pool_new)(&pool), assert(t == PP_(at)(run, 3));
+	t = P_(pool_new)(&pool), assert(t == PP_(at)(run, 299000));
+	assert(!PP_(free0_size)(&pool) && pool.slots.data[0].size == size);
+	/* Removing the tail shrinks over every exposed removed item. */
+	for(i = size - 10; i < size - 1; i++)
+		r = P_(pool_remove)(&pool, PP_(at)(run, i)), assert(r);
+	assert(PP_(free0_size)(&pool) == 9);
+	r = P_(pool_remove)(&pool, PP_(at)(run, size - 1)), assert(r);
+	PP_(valid_state)(&pool);
+	assert(!PP_(free0_size)(&pool) && pool.slots.data[0].size == size - 10);
+	P_(pool_)(&pool);
+	printf("Done free-bitmap tests.\n\n");
+}
+#endif /* bitmap --> */
+
+#ifdef POOL_BLOCK /* <!-- block */
+static void PP_(test_block)(void) {
+	struct P_(pool) pool = P_(pool)();
+	const size_t max = (POOL_BLOCK_MASK + 1 - sizeof(struct pool_block_head))
+		/ sizeof(PP_(type));
+	PP_(type) *run;
+	size_t i, c;
+	int r;
+
+	printf("Blocks of %lu.\n", (unsigned long)max);
+	errno = 0;
+	run = P_(pool_new_n)(&pool, max + 1), assert(!run && errno == ERANGE);
+	errno = 0;
+	run = P_(pool_new_n)(&pool, max), assert(run && pool.capacity0 == max);
+	for(i = 0; i < max; i++) PP_(filler)(PP_(at)(run, i));
+	/* Growing past a block starts another block. */
+	for(i = 0; i < 3 * max; i++) assert(P_(pool_new)(&pool));
+	PP_(valid_state)(&pool);
+	assert(pool.slots.size == 4);
+	c = PP_(block_head)(run)->slot;
+	assert(c && pool.slots.data[c].slab == run);
+	for(i = 0; i < max; i++) {
+		assert(PP_(block_head)(PP_(at)(run, i))->slot == c);
+		r = P_(pool_remove)(&pool, PP_(at)(run, i)), assert(r);
+	}
+	PP_(valid_state)(&pool);
+	assert(pool.slots.size == 3);
+	P_(pool_)(&pool);
+	printf("Done block tests.\n\n");
+}
+#endif /* block --> */
+
+#ifdef POOL_HUGE /* <!-- huge */
+static void PP_(test_huge)(void) {
+	struct P_(pool) pool = P_(pool)();
+	PP_(type) *x, *run, *ptrs[3];
+	size_t capacity;
+	int r;
+
+	printf("Huge pages of %lu.\n", (unsigned long)POOL_HUGE_MASK + 1);
+	x = P_(pool_new)(&pool), assert(x), PP_(filler)(x);
+	PP_(valid_state)(&pool);
+	capacity = pool.capacity0;
+	assert(pool.slots.size == 1 && capacity >= POOL_SLAB_MIN_CAPACITY
+		&& PP_(huge_bytes)(capacity) == POOL_HUGE_MASK + 1);
+	/* A run that doesn't fit goes over more than one page. */
+	run = P_(pool_new_n)(&pool, capacity), assert(run);
+	PP_(valid_state)(&pool);
+	assert(pool.slots.size == 2 && pool.capacity0 > capacity
+		&& PP_(huge_bytes)(pool.capacity0) > POOL_HUGE_MASK + 1);
+	/* Empty secondary slabs are unmapped, singly and batched. */
+	r = P_(pool_remove)(&pool, x), assert(r && pool.slots.size == 1);
+	x = P_(pool_new_n)(&pool, pool.capacity0), assert(x);
+	PP_(valid_state)(&pool);
+	assert(pool.slots.size == 2);
+	ptrs[0] = run, ptrs[1] = PP_(at)(run, capacity - 1), ptrs[2] = x;
+	r = P_(pool_remove_n)(&pool, ptrs, 3), assert(r);
+	PP_(valid_state)(&pool);
+	assert(pool.slots.size == 2 && pool.slots.data[1].size == capacity - 2);
+	P_(pool_clear)(&pool);
+	assert(pool.slots.size == 1);
+	P_(pool_)(&pool);
+	printf("Done huge tests.\n\n");
+}
+#endif /* huge --> */
+
+#ifdef POOL_ALIGNMENT /* <!-- align */
+static void PP_(test_align)(void) {
+	struct P_(pool) pool = P_(pool)();
+	PP_(type) *x[40];
+	const size_t x_size = sizeof x / sizeof *x;
+	size_t i;
+	int r;
+
+	printf("Alignment %lu, stride %lu.\n", (unsigned long)POOL_ALIGNMENT,
+		(unsigned long)POOL_STRIDE);
+	assert(POOL_STRIDE >= sizeof(PP_(type))
+		&& !(POOL_STRIDE % POOL_ALIGNMENT));
+	for(i = 0; i < x_size; i++) {
+		x[i] = P_(pool_new)(&pool), assert(x[i]), PP_(filler)(x[i]);
+		assert(!(POOL_ADDRESS(x[i]) & (POOL_ALIGNMENT - 1)));
+	}
+	PP_(valid_state)(&pool);
+	assert(pool.slots.size > 1);
+	/* Items in a slab are a stride apart. */
+	assert(PP_(index)(pool.slots.data[0].slab,
+		PP_(at)(pool.slots.data[0].slab, 3)) == 3);
+#ifdef POOL_CACHELINE_ISOLATE
+	/* No two items share a cache-line. */
+	for(i = 1; i < x_size; i++) assert(POOL_ADDRESS(x[i - 1]) >> 6
+		!= POOL_ADDRESS(x[i]) >> 6);
+#endif
+	for(i = 0; i < x_size; i += 2)
+		r = P_(pool_remove)(&pool, x[i]), assert(r);
+	PP_(valid_state)(&pool);
+	P_(pool_)(&pool);
+	printf("Done align tests.\n\n");
+}
+#endif /* align --> */
+
+#ifdef POOL_COLOUR /* <!-- colour */
+static void PP_(test_colour)(void) {
+	struct P_(pool) pool = P_(pool)();
+	struct P_(pool_stats) stats;
+	size_t colour[POOL_COLOUR + 2], i, j;
+	const size_t colour_size = sizeof colour / sizeof *colour;
+	PP_(type) *x;
+
+	printf("Colours %lu of %lu bytes.\n", (unsigned long)POOL_COLOUR,
+		(unsigned long)POOL_COLOUR_LINE);
+	/* Each slab zero is full before the next, so all of them are kept. */
+	P_(pool_stats)(&pool, &stats);
+	assert(stats.base_colour < POOL_COLOUR
+		&& stats.next_colour == stats.base_colour);
+	for(i = 0; i < colour_size; i++) {
+		x = P_(pool_new_n)(&pool, pool.capacity0 + 1), assert(x);
+		PP_(filler)(x);
+		colour[i] = PP_(slab_head)(pool.slots.data[0].slab).colour;
+		PP_(valid_state)(&pool);
+		/* The stats see the same colours. */
+		P_(pool_stats)(&pool, &stats);
+		assert(stats.base_colour == colour[0]
+			&& stats.next_colour == (colour[i] + 1) % POOL_COLOUR);
+	}
+	assert(pool.slots.size == colour_size);
+	/* They rotate from where the pool started. */
+	for(i = 1; i < colour_size; i++)
+		assert(colour[i] == (colour[i - 1] + 1) % POOL_COLOUR);
+	/* Every colour is used; the same item is on a different line. */
+	for(i = 0; i < POOL_COLOUR; i++) for(j = i + 1; j < POOL_COLOUR; j++)
+		assert(colour[i] != colour[j]);
+	P_(pool_)(&pool);
+	printf("Done colour tests.\n\n");
+}
+#endif /* colour --> */
+
+#ifdef POOL_RETAIN /* <!-- retain */
+static void PP_(test_retain)(void) {
+	struct P_(pool) pool = P_(pool)();
+	PP_(type) *a, *b, *c;
+	size_t i;
+	int r;
+
+	printf("Retain %lu, decay %lu.\n", (unsigned long)POOL_RETAIN,
+		(unsigned long)POOL_RETAIN_DECAY);
+	/* An emptied secondary slab is retained. */
+	a = P_(pool_new_n)(&pool, 100), assert(a && pool.capacity0 == 100);
+	b = P_(pool_new_n)(&pool, 100), assert(b && pool.slots.size == 2);
+	for(i = 0; i < 100; i++)
+		r = P_(pool_remove)(&pool, PP_(at)(a, i)), assert(r);
+	PP_(valid_state)(&pool);
+	assert(pool.slots.size == 1 && pool.retained_size == 1
+		&& pool.retained[0].slab == a);
+	/* The next slab zero is it, because it fits, though it's smaller. */
+	c = P_(pool_new_n)(&pool, pool.capacity0 - pool.slots.data[0].size + 1);
+	PP_(valid_state)(&pool);
+	assert(c == a && pool.capacity0 == 100 && !pool.retained_size
+		&& pool.slots.size == 2);
+	for(i = 0; i < 100; i++)
+		r = P_(pool_remove)(&pool, PP_(at)(b, i)), assert(r);
+	PP_(valid_state)(&pool);
+	assert(pool.slots.size == 1 && pool.retained_size == 1);
+	/* Every new slab zero is too big for it, so it ages until it's freed. */
+	for(i = 0; i <= POOL_RETAIN_DECAY; i++) {
+		assert(pool.retained_size == 1);
+		c = P_(pool_new_n)(&pool, pool.capacity0 + 200), assert(c);
+		PP_(valid_state)(&pool);
+	}
+	assert(!pool.retained_size);
+	/* Only so many are retained. */
+	P_(pool_clear)(&pool);
+	PP_(valid_state)(&pool);
+	assert(pool.slots.size == 1 && pool.retained_size);
+	P_(pool_)(&pool);
+	assert(!pool.retained_size);
+	printf("Done retain tests.\n\n");
+}
+#endif /* retain --> */
+
+#ifdef POOL_RESERVE /* <!-- reserve */
+static void PP_(test_reserve)(void) {
+	struct P_(pool) pool = P_(pool)();
+	const size_t max = ((size_t)1 << POOL_RESERVE) / POOL_STRIDE,
+		run_size = 100;
+	PP_(type) *run, *slab, *t;
+	size_t i, capacity;
+	int r;
+
+	printf("Reserve of %lu.\n", (unsigned long)max);
+	errno = 0;
+	run = P_(pool_new_n)(&pool, max + 1);
+	assert(!run && errno == ERANGE && !pool.slots.size);
+	errno = 0;
+	run = P_(pool_new_n)(&pool, run_size), assert(run);
+	for(i = 0; i < run_size; i++) PP_(filler)(PP_(at)(run, i));
+	slab = pool.slots.data[0].slab;
+	/* The holes and the items stay put while it grows. */
+	r = P_(pool_remove)(&pool, PP_(at)(run, 50)), assert(r);
+	r = P_(pool_remove)(&pool, PP_(at)(run, 10)), assert(r);
+	for(i = 0; i < 8; i++) {
+		capacity = pool.capacity0;
+		t = P_(pool_new_n)(&pool, capacity - pool.slots.data[0].size + 1);
+		assert(t);
+		PP_(valid_state)(&pool);
+		assert(pool.slots.size == 1 && pool.slots.data[0].slab == slab
+			&& pool.capacity0 > capacity && PP_(free0_size)(&pool) == 2);
+	}
+	printf("Capacity %lu.\n", (unsigned long)pool.capacity0);
+	t = P_(pool_new)(&pool);
+	assert(t == PP_(at)(run, 10) || t == PP_(at)(run, 50));
+#ifdef POOL_FREE_BITMAP
+	assert(t == PP_(at)(run, 10));
+#endif
+	P_(pool_clear)(&pool);
+	assert(pool.slots.size == 1 && pool.slots.data[0].slab == slab
+		&& !pool.slots.data[0].size);
+	P_(pool_)(&pool);
+	printf("Done reserve tests.\n\n");
+}
+#endif /* reserve --> */
+
+/** Checks `stats` of `pool` against the slots. */
+static void PP_(valid_stats)(const struct P_(pool) *const pool,
+	const struct P_(pool_stats) *const stats) {
+	const size_t size0 = pool->slots.size ? pool->slots.data[0].size : 0;
+	PP_(valid_state)(pool);
+	assert(stats->size == pool->size && stats->capacity == pool->capacity
+		&& stats->capacity0 == pool->capacity0
+		&& stats->slabs == pool->slots.size
+		&& stats->free0 == PP_(free0_size)(pool)
+		&& stats->capacity * sizeof(PP_(type)) + stats->metadata
+		<= stats->bytes && stats->free0_bytes <= stats->metadata
+		&& stats->size <= stats->peak_size
+		&& stats->bytes <= stats->peak_bytes
+		&& stats->fragmentation >= 0.0 && stats->fragmentation < 1.0);
+	/* Free space that's not the tail. */
+	assert(!stats->capacity || (size_t)(stats->fragmentation
+		* (double)stats->capacity + 0.5)
+		== stats->capacity - stats->size - (stats->capacity0 - size0));
+}
+
+static void PP_(test_stats)(void) {
+	struct P_(pool) pool = P_(pool)();
+	struct P_(pool_stats) stats;
+	PP_(type) *a, *b;
+	size_t i, n, peak_bytes;
+	int r;
+
+	printf("Stats.\n");
+	P_(pool_stats)(&pool, &stats);
+	assert(!stats.size && !stats.capacity && !stats.slabs && !stats.bytes
+		&& !stats.peak_size && !stats.peak_bytes && !stats.fragmentation);
+	a = P_(pool_new_n)(&pool, 10), assert(a);
+	for(i = 0; i < 10; i++) PP_(filler)(PP_(at)(a, i));
+	P_(pool_stats)(&pool, &stats), PP_(valid_stats)(&pool, &stats);
+	assert(stats.size == 10 && stats.slabs == 1 && stats.peak_size == 10
+		&& !stats.free0 && !stats.fragmentation);
+	/* A hole in slab zero is fragmentation. */
+	r = P_(pool_remove)(&pool, PP_(at)(a, 3)), assert(r);
+	P_(pool_stats)(&pool, &stats), PP_(valid_stats)(&pool, &stats);
+	assert(stats.size == 9 && stats.free0 == 1 && stats.fragmentation > 0.0);
+	/* Past the capacity, slab zero grows, or is evicted with it's hole. */
+	n = pool.capacity0 - pool.slots.data[0].size + 1;
+	b = P_(pool_new_n)(&pool, n), assert(b);
+	for(i = 0; i < n; i++) PP_(filler)(PP_(at)(b, i));
+	P_(pool_stats)(&pool, &stats), PP_(valid_stats)(&pool, &stats);
+	assert(stats.size == 9 + n && stats.peak_size == 9 + n);
+#ifndef POOL_RESERVE
+	assert(stats.slabs == 2 && stats.capacity > stats.capacity0);
+#endif
+	peak_bytes = stats.peak_bytes;
+	/* Watermarks stay. */
+	for(i = 0; i < n; i++)
+		r = P_(pool_remove)(&pool, PP_(at)(b, i)), assert(r);
+	for(i = 0; i < 10; i++) if(i != 3)
+		r = P_(pool_remove)(&pool, PP_(at)(a, i)), assert(r);
+	P_(pool_stats)(&pool, &stats), PP_(valid_stats)(&pool, &stats);
+	assert(!stats.size && stats.peak_size == 9 + n
+		&& stats.peak_bytes >= peak_bytes);
+	printf("Peak %lu items in %lu bytes.\n", (unsigned long)stats.peak_size,
+		(unsigned long)stats.peak_bytes);
+	P_(pool_)(&pool);
+	printf("Done stats tests.\n\n");
+}
+
+#ifdef POOL_STATS /* <!-- stats */
+static void PP_(test_counters)(void) {
+	struct P_(pool) pool = P_(pool)();
+	struct P_(pool_counters) c;
+	PP_(type) *a, *b, *t;
+	size_t i, n;
+	int r;
+
+	printf("Counters.\n");
+	P_(pool_counters_clear)();
+	P_(pool_counters)(&c);
+	assert(!c.new_free0 && !c.new_tail && !c.room && !c.grow && !c.remove0
+		&& !c.remove_slab && !c.release && !c.upper && !c.upper_depth);
+	a = P_(pool_new_n)(&pool, 10), assert(a);
+	for(i = 0; i < 10; i++) PP_(filler)(PP_(at)(a, i));
+	r = P_(pool_remove)(&pool, PP_(at)(a, 3)), assert(r);
+	t = P_(pool_new)(&pool), assert(t == PP_(at)(a, 3));
+	P_(pool_counters)(&c);
+	assert(c.new_free0 == 1 && c.new_tail == 10 && c.room == 2
+		&& c.grow == 1 && c.remove0 == 1 && !c.remove_slab);
+	/* Past the capacity, slab zero is evicted. */
+	n = pool.capacity0 - pool.slots.data[0].size + 1;
+	b = P_(pool_new_n)(&pool, n), assert(b);
+	for(i = 0; i < n; i++) PP_(filler)(PP_(at)(b, i));
+	for(i = 0; i < 10; i++)
+		r = P_(pool_remove)(&pool, PP_(at)(a, i)), assert(r);
+	P_(pool_counters)(&c);
+	assert(c.new_tail == 10 + n && c.room == 3 && c.grow == 2
+		&& c.remove0 == 1 && c.remove_slab == 10 && c.release == 1);
+	P_(pool_counters_print)(stdout);
+	P_(pool_)(&pool);
+	printf("Done counters tests.\n\n");
+}
+#endif /* stats --> */
+
+#ifdef POOL_TRACE /* <!-- trace */
+static void PP_(test_trace)(void) {
+	struct P_(pool) pool = P_(pool)();
+	struct pool_trace trace;
+	struct pool_trace_event e;
+	PP_(type) *a[3], *run, *ptrs[2];
+	const PP_(type) *expect[8];
+	const enum pool_trace_op op[] = { POOL_TRACE_NEW, POOL_TRACE_NEW,
+		POOL_TRACE_NEW, POOL_TRACE_NEW, POOL_TRACE_NEW, POOL_TRACE_REMOVE,
+		POOL_TRACE_REMOVE, POOL_TRACE_REMOVE, POOL_TRACE_CLEAR };
+	FILE *fp = tmpfile();
+	size_t i, size;
+	int r;
+
+	printf("Trace.\n");
+	assert(fp);
+	r = pool_trace_begin(&trace, fp, sizeof(PP_(type))), assert(r);
+	/* Before the trace is set, nothing. */
+	a[0] = P_(pool_new)(&pool), assert(a[0]), PP_(filler)(a[0]);
+	P_(pool_set_trace)(&pool, &trace);
+	for(i = 1; i < 3; i++)
+		a[i] = P_(pool_new)(&pool), assert(a[i]), PP_(filler)(a[i]);
+	run = P_(pool_new_n)(&pool, 2), assert(run);
+	r = P_(pool_new_ptrs)(&pool, ptrs, 1), assert(r);
+	r = P_(pool_remove)(&pool, a[1]), assert(r);
+	ptrs[1] = run + 1;
+	r = P_(pool_remove_n)(&pool, ptrs, 2), assert(r);
+	P_(pool_clear)(&pool);
+	expect[0] = a[1], expect[1] = a[2], expect[2] = run,
+		expect[3] = run + 1, expect[4] = ptrs[0], expect[5] = a[1],
+		expect[6] = ptrs[0], expect[7] = ptrs[1];
+	P_(pool_set_trace)(&pool, 0);
+	P_(pool_)(&pool);
+	r = pool_trace_end(&trace), assert(r);
+	rewind(fp);
+	r = pool_trace_read(&trace, fp, &size), assert(r);
+	assert(size == sizeof(PP_(type)));
+	for(i = 0; pool_trace_next(&trace, &e); i++) {
+		assert(i < sizeof op / sizeof *op && e.op == op[i]);
+		if(e.op != POOL_TRACE_CLEAR)
+			assert(e.address == POOL_ADDRESS(expect[i]));
+	}
+	assert(i == sizeof op / sizeof *op && !trace.error);
+	fclose(fp);
+	printf("Done trace tests.\n\n");
+}
+#endif /* trace --> */
+
+#ifdef POOL_SAMPLE /* <!-- sample */
+/** @return The live samples in `s`, checking they agree with the stacks. */
+static size_t PP_(sample_live)(const struct pool_sample *const s) {
+	size_t i, live = 0;
+	for(i = 0; i < s->stacks.size; i++) live += s->stacks.data[i].live;
+	assert(live == s->live.size);
+	return live;
+}
+
+static void PP_(test_sample)(void) {
+	struct P_(pool) pool = P_(pool)();
+	struct pool_sample sample;
+	PP_(type) *a[10], *run, *many[4000];
+	const size_t many_size = sizeof many / sizeof *many;
+	FILE *fp = tmpfile();
+	size_t i, live;
+	int r;
+
+	printf("Sample.\n");
+	assert(fp);
+	pool_sample_begin(&sample, 1);
+	/* Before the sample is set, nothing. */
+	a[0] = P_(pool_new)(&pool), assert(a[0]), PP_(filler)(a[0]);
+	P_(pool_set_sample)(&pool, &sample);
+	assert(sample.item_size >= sizeof(PP_(type)));
+	for(i = 1; i < sizeof a / sizeof *a; i++)
+		a[i] = P_(pool_new)(&pool), assert(a[i]), PP_(filler)(a[i]);
+	run = P_(pool_new_n)(&pool, 5), assert(run);
+	/* Every one, from two places. */
+	assert(PP_(sample_live)(&sample) == 9 + 5 && sample.stacks.size == 2);
+	r = P_(pool_remove)(&pool, a[0]), assert(r);
+	for(i = 1; i < 4; i++)
+		r = P_(pool_remove)(&pool, a[i]), assert(r);
+	r = P_(pool_remove_n)(&pool, a + 4, 2), assert(r);
+	assert(PP_(sample_live)(&sample) == 9 + 5 - 5);
+	P_(pool_clear)(&pool);
+	assert(!PP_(sample_live)(&sample) && sample.stacks.size == 2
+		&& sample.stacks.data[0].total + sample.stacks.data[1].total == 14);
+	/* Tuned down, about a quarter. */
+	pool_sample_rate(&sample, 4);
+	r = P_(pool_new_ptrs)(&pool, many, many_size), assert(r);
+	live = PP_(sample_live)(&sample);
+	printf("Sampled %lu of %lu at one in four.\n", (unsigned long)live,
+		(unsigned long)many_size);
+	assert(live > many_size / 8 && live < many_size / 2);
+	for(i = 0; i < many_size; i += 2)
+		r = P_(pool_remove)(&pool, many[i]), assert(r);
+	assert(PP_(sample_live)(&sample) < live);
+	r = pool_sample_report(&sample, fp), assert(r);
+	assert(ftell(fp) > 0);
+	P_(pool_set_sample)(&pool, 0);
+	P_(pool_)(&pool);
+	r = pool_sample_end(&sample), assert(r);
+	fclose(fp);
+	printf("Done sample tests.\n\n");
+}
+#endif /* sample --> */
+
+static void PP_(test_trim)(void) {
+	struct P_(pool) pool = P_(pool)();
+	PP_(type) *a, *b;
+	size_t i, n, capacity, bytes, released;
+	int r;
+
+	printf("Trim.\n");
+	assert(!P_(pool_trim)(&pool));
+	a = P_(pool_new_n)(&pool, 100), assert(a);
+	for(i = 0; i < 100; i++) PP_(filler)(PP_(at)(a, i));
+	/* A spike, then it goes away from the tail. */
+	n = pool.capacity0;
+	b = P_(pool_new_n)(&pool, n), assert(b);
+	for(i = 0; i < n; i++) PP_(filler)(PP_(at)(b, i));
+	capacity = pool.capacity0;
+	for(i = n; i; i--)
+		r = P_(pool_remove)(&pool, PP_(at)(b, i - 1)), assert(r);
+	PP_(valid_state)(&pool);
+	bytes = PP_(footprint)(&pool);
+	released = P_(pool_trim)(&pool);
+	PP_(valid_state)(&pool);
+	printf("Trimmed %lu bytes from capacity %lu to %lu.\n",
+		(unsigned long)released, (unsigned long)capacity,
+		(unsigned long)pool.capacity0);
+#if defined(POOL_RESERVE) || defined(POOL_HUGE)
+	/* The pages past the tail are gone. */
+	assert(released && pool.capacity0 < capacity
+		&& pool.capacity0 >= pool.slots.data[0].size);
+#ifdef POOL_HUGE
+	/* Slab zero is what fits in the huge pages that are left. */
+	assert(pool.capacity0 == (PP_(huge_bytes)(pool.slots.data[0].size)
+		- sizeof(struct pool_huge_head)) / POOL_STRIDE
+		&& PP_(huge_head)(pool.slots.data[0].slab)->capacity == pool.capacity0);
+#endif
+#elif !defined(POOL_BLOCK)
+	assert(released && pool.capacity0 == POOL_SLAB_MIN_CAPACITY);
+#endif
+	/* And no longer counted. */
+	assert(!released == (PP_(footprint)(&pool) == bytes)
+		&& PP_(footprint)(&pool) <= bytes);
+	/* It still works. */
+	b = P_(pool_new_n)(&pool, 10), assert(b);
+	for(i = 0; i < 10; i++) PP_(filler)(PP_(at)(b, i));
+	PP_(valid_state)(&pool);
+	/* Empty, it gives back everything. */
+	for(i = 0; i < 100; i++)
+		r = P_(pool_remove)(&pool, PP_(at)(a, i)), assert(r);
+	for(i = 0; i < 10; i++)
+		r = P_(pool_remove)(&pool, PP_(at)(b, i)), assert(r);
+	PP_(valid_state)(&pool);
+	released = P_(pool_trim)(&pool);
+	PP_(valid_state)(&pool);
+	assert(released && !pool.slots.size && !pool.capacity0);
+#ifdef POOL_RETAIN
+	assert(!pool.retained_size && !pool.retained_bytes);
+#endif
+	assert(!P_(pool_trim)(&pool));
+	a = P_(pool_new)(&pool), assert(a), PP_(filler)(a);
+	PP_(valid_state)(&pool);
+	P_(pool_)(&pool);
+	printf("Done trim tests.\n\n");
+}
+
+#ifdef POOL_PAGE_FREE /* <!-- page */
+static void PP_(test_page)(void) {
+	struct P_(pool) pool = P_(pool)();
+	const size_t n = 8 * POOL_PAGE / POOL_STRIDE + 1;
+	PP_(type) *run, *x[2];
+	size_t o, p, lo, hi, i;
+	int r;
+
+	printf("Pages of %lu.\n", (unsigned long)POOL_PAGE);
+	run = P_(pool_new_n)(&pool, n), assert(run);
+	for(i = 0; i < n; i++) PP_(filler)(PP_(at)(run, i));
+	PP_(valid_state)(&pool);
+	/* A page in the middle has every item on it removed, from both ends. */
+	o = PP_(page_offset)(&pool);
+	p = (o + n / 2 * POOL_STRIDE) >> POOL_PAGE_FREE;
+	lo = ((p << POOL_PAGE_FREE) - o) / POOL_STRIDE;
+	hi = (((p + 1) << POOL_PAGE_FREE) - o + POOL_STRIDE - 1) / POOL_STRIDE;
+	assert(pool.page_live[p] == hi - lo && hi < n);
+	for(i = 0; i < hi - lo; i++) r = P_(pool_remove)(&pool,
+		PP_(at)(run, i & 1 ? lo + i / 2 : hi - 1 - i / 2)), assert(r);
+	PP_(valid_state)(&pool);
+	assert(!pool.page_live[p] && pool.slots.data[0].size == n);
+	/* It comes back, (faulted in,) when it's used again. */
+	x[0] = P_(pool_new)(&pool), assert(x[0]), PP_(filler)(x[0]);
+	r = P_(pool_new_ptrs)(&pool, x + 1, 1), assert(r), PP_(filler)(x[1]);
+	assert(pool.page_live[p] && PP_(index)(run, x[0]) >= lo
+		&& PP_(index)(run, x[0]) < hi);
+	PP_(valid_state)(&pool);
+	P_(pool_clear)(&pool);
+	PP_(valid_state)(&pool);
+	for(i = 0; i < pool.page_capacity; i++) assert(!pool.page_live[i]);
+	run = P_(pool_new_n)(&pool, n), assert(run), PP_(filler)(run);
+	PP_(valid_state)(&pool);
+	P_(pool_)(&pool);
+	printf("Done page tests.\n\n");
+}
+#endif /* page --> */
+
+#ifdef POOL_LIMIT /* <!-- limit */
+/* The items a pool has for <fn:<PP>test_reclaim>. */
+struct PP_(reclaim) { struct P_(pool) *pool; PP_(type) **x; size_t size;
+	unsigned calls; int is_giving; };
+/** Removes the `n` newest items of `param` from `pool`, if it's giving.
+ @implements <PP>reclaim_fn */
+static int PP_(test_reclaim)(struct P_(pool) *const pool, const size_t n,
+	void *const param) {
+	struct PP_(reclaim) *const r = param;
+	size_t i;
+	int ok;
+	assert(r && r->pool == pool);
+	r->calls++;
+	if(!r->is_giving || r->size < n) return 0;
+	for(i = 0; i < n; i++)
+		ok = P_(pool_remove)(pool, r->x[--r->size]), assert(ok);
+	return 1;
+}
+
+static void PP_(test_limit)(void) {
+	struct P_(pool) pool = P_(pool)();
+#ifdef POOL_HUGE
+	const size_t limit = (size_t)3 << POOL_HUGE;
+#else
+	const size_t limit = 3 * 4096 + 512;
+#endif
+	const size_t x_max = limit / sizeof(PP_(type)) + 1;
+	struct PP_(reclaim) r;
+	PP_(type) *x;
+
+	printf("Limit of %lu bytes.\n", (unsigned long)limit);
+	r.pool = &pool, r.size = 0, r.calls = 0, r.is_giving = 0;
+	r.x = malloc(sizeof *r.x * x_max), assert(r.x);
+	P_(pool_set_limit)(&pool, limit);
+	P_(pool_set_reclaim)(&pool, &PP_(test_reclaim), &r);
+	/* Growth is clamped up to the limit, and then it fails. */
+	errno = 0;
+	while((x = P_(pool_new)(&pool)))
+		assert(r.size < x_max), PP_(filler)(x), r.x[r.size++] = x;
+	assert(errno == POOL_LIMIT_ERRNO && r.calls == 1);
+	PP_(valid_state)(&pool);
+	printf("%lu items in %lu bytes.\n", (unsigned long)r.size,
+		(unsigned long)PP_(footprint)(&pool));
+	assert(PP_(footprint)(&pool) <= limit + limit / 8
+		&& r.size * POOL_STRIDE > limit / 2);
+	/* Reclaim makes room. */
+	r.is_giving = 1, errno = 0;
+	x = P_(pool_new)(&pool), assert(x && r.calls == 2);
+	PP_(filler)(x), r.x[r.size++] = x;
+	PP_(valid_state)(&pool);
+	/* More than the limit fails, even after reclaim. */
+	x = P_(pool_new_n)(&pool, limit / POOL_STRIDE + 1);
+	assert(!x && errno == POOL_LIMIT_ERRNO && r.calls == 3);
+	PP_(valid_state)(&pool);
+	/* Without a limit, it's fine. */
+	P_(pool_set_limit)(&pool, 0);
+	x = P_(pool_new_n)(&pool, limit / POOL_STRIDE + 1);
+	assert(x && r.calls == 3);
+	PP_(valid_state)(&pool);
+	P_(pool_)(&pool);
+	free(r.x);
+	printf("Done limit tests.\n\n");
+}
+#endif /* limit --> */
+
 /** The list will be tested on stdout; requires `POOL_TEST` and not `NDEBUG`.
  @allow */
 static void P_(pool_test)(void) {
@@ -354,7 +1252,51 @@ static void P_(pool_test)(void) {
 		"POOL_TEST<" QUOTE(POOL_TEST) ">; "
 #endif
 		"testing:\n");
+#if !defined(POOL_HUGE) && !defined(POOL_RESERVE)
 	PP_(test_states)();
+#endif
+	PP_(test_bulk)();
+#if !defined(POOL_HUGE) && !defined(POOL_RESERVE)
+	PP_(test_remove_n)();
+#endif
+#ifdef POOL_FREE_BITMAP
+	PP_(test_bitmap)();
+#endif
+#ifdef POOL_BLOCK
+	PP_(test_block)();
+#endif
+#ifdef POOL_HUGE
+	PP_(test_huge)();
+#endif
+#ifdef POOL_ALIGNMENT
+	PP_(test_align)();
+#endif
+#ifdef POOL_COLOUR
+	PP_(test_colour)();
+#endif
+#ifdef POOL_RETAIN
+	PP_(test_retain)();
+#endif
+#ifdef POOL_RESERVE
+	PP_(test_reserve)();
+#endif
+#ifdef POOL_PAGE_FREE
+	PP_(test_page)();
+#endif
+#ifdef POOL_LIMIT
+	PP_(test_limit)();
+#endif
+#ifdef POOL_STATS
+	PP_(test_counters)();
+#endif
+#ifdef POOL_TRACE
+	PP_(test_trace)();
+#endif
+#ifdef POOL_SAMPLE
+	PP_(test_sample)();
+#endif
+	PP_(test_stats)();
+	PP_(test_trim)();
 	PP_(test_random)();
 	fprintf(stderr, "Done tests of <" QUOTE(POOL_NAME) ">pool.\n\n");
 }
@@ -0,0 +1,569 @@
+#define _POSIX_C_SOURCE 200112L /* clock_gettime */
+#define _DEFAULT_SOURCE /* MAP_ANONYMOUS syscall */
+#include <stdlib.h> /* EXIT_ malloc free */
+#include <stdio.h>  /* fprintf */
+#include <string.h>	/* memcpy */
+#include <time.h>	/* clock clock_gettime */
+#include <pthread.h>
+#include <assert.h> /* assert */
+#include "orcish.h"
+#include "pool_timing.h"
+#include "replay.h"
+#ifdef __linux__ /* <!-- linux */
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+/* The count that a perf event reads; named once, so `-ansi -pedantic` doesn't
+ warn about `long long`. */
+__extension__ typedef unsigned long long perf_count;
+#endif /* linux --> */
+
+
+/* Compile with `-DTIMING_STATS` to count the hot paths of the pools in the
+ free-list timing, on `stderr`; it slows them down. */
+#ifdef TIMING_STATS
+#define TIMING_CLEAR(pool) pool##_pool_counters_clear()
+#define TIMING_COUNTERS(pool, length) \
+	(fprintf(stderr, #pool " %lu: ", (unsigned long)(length)), \
+	pool##_pool_counters_print(stderr))
+#else
+#define TIMING_CLEAR(pool) (void)0
+#define TIMING_COUNTERS(pool, length) (void)0
+#endif
+
+struct keyval { int key; char value[12]; };
+static void keyval_filler(struct keyval *const kv)
+	{ kv->key = rand() / (RAND_MAX / 1098 + 1) - 99;
+	orcish(kv->value, sizeof kv->value); }
+#define POOL_NAME keyval
+#define POOL_TYPE struct keyval
+#ifdef TIMING_STATS
+#define POOL_STATS
+#endif
+#include "../../src/pool.h"
+#define POOL_NAME kvlist
+#define POOL_TYPE struct keyval
+#define POOL_FREE_LIST
+#ifdef TIMING_STATS
+#define POOL_STATS
+#endif
+#include "../../src/pool.h"
+#define POOL_NAME kvbitmap
+#define POOL_TYPE struct keyval
+#define POOL_FREE_BITMAP
+#ifdef TIMING_STATS
+#define POOL_STATS
+#endif
+#include "../../src/pool.h"
+#define POOL_NAME kvradix
+#define POOL_TYPE struct keyval
+#define POOL_RADIX 16
+#include "../../src/pool.h"
+#define POOL_NAME kvblock
+#define POOL_TYPE struct keyval
+#define POOL_BLOCK 20
+#include "../../src/pool.h"
+#define POOL_NAME kvinline
+#define POOL_TYPE struct keyval
+#define POOL_INLINE_SLOTS
+#include "../../src/pool.h"
+#define POOL_NAME kvhuge
+#define POOL_TYPE struct keyval
+#define POOL_HUGE 21
+#include "../../src/pool.h"
+#define POOL_NAME kvcolour
+#define POOL_TYPE struct keyval
+#define POOL_COLOUR 8
+#include "../../src/pool.h"
+#define POOL_NAME keyval
+#define POOL_TYPE struct keyval
+#include "../../src/magazine.h"
+#define POOL_NAME keyval
+#define POOL_TYPE struct keyval
+#include "../../src/percpu.h"
+#define POOL_NAME keyval
+#define POOL_TYPE struct keyval
+#include "../../src/owner.h"
+#define POOL_NAME keyval
+#define POOL_TYPE struct keyval
+#include "../../src/lockfree.h"
+
+/** Returns a time diffecence in microseconds from `then`. */
+static double diff_us(clock_t then)
+	{ return 1000000.0 / CLOCKS_PER_SEC * (clock() - then); }
+
+/* Fills `a` with `length` items, referenced in random order by `ptrs`. */
+#define POOL_FILL(pool, a, ptrs, length) do { \
+	struct keyval *temp_; \
+	size_t i_, j_; \
+	for(i_ = 0; i_ < (length); i_++) { \
+		(ptrs)[i_] = pool##_pool_new(a), assert((ptrs)[i_]); \
+		keyval_filler((ptrs)[i_]); \
+	} \
+	for(i_ = (length) - 1; i_; i_--) { \
+		j_ = (size_t)rand() / (RAND_MAX / (i_ + 1) + 1); \
+		temp_ = (ptrs)[i_], (ptrs)[i_] = (ptrs)[j_], (ptrs)[j_] = temp_; \
+	} \
+} while(0)
+
+/** Tears down `length` items in random order, one at a time and batched, and
+ one at a time with aligned slabs, with blocks, and with inline slots;
+ outputs the times to `fp`. */
+void teardown_timing(const size_t length, FILE *const fp) {
+	struct keyval_pool a = keyval_pool();
+	struct kvradix_pool b = kvradix_pool();
+	struct kvblock_pool c = kvblock_pool();
+	struct kvinline_pool d = kvinline_pool();
+	struct keyval **ptrs;
+	const unsigned seed = (unsigned)clock();
+	size_t i;
+	clock_t t;
+
+	if(!length || !(ptrs = malloc(sizeof *ptrs * length)))
+		{ perror("teardown"); return; }
+
+	srand(seed); POOL_FILL(keyval, &a, ptrs, length);
+	t = clock();
+	for(i = 0; i < length; i++) keyval_pool_remove(&a, ptrs[i]);
+	fprintf(fp, "%lu\t%f", (unsigned long)length, diff_us(t));
+	keyval_pool_(&a);
+
+	srand(seed); POOL_FILL(keyval, &a, ptrs, length);
+	t = clock();
+	keyval_pool_remove_n(&a, ptrs, length);
+	fprintf(fp, "\t%f", diff_us(t));
+	keyval_pool_(&a);
+
+	srand(seed); POOL_FILL(kvradix, &b, ptrs, length);
+	t = clock();
+	for(i = 0; i < length; i++) kvradix_pool_remove(&b, ptrs[i]);
+	fprintf(fp, "\t%f", diff_us(t));
+	kvradix_pool_(&b);
+
+	srand(seed); POOL_FILL(kvblock, &c, ptrs, length);
+	t = clock();
+	for(i = 0; i < length; i++) kvblock_pool_remove(&c, ptrs[i]);
+	fprintf(fp, "\t%f", diff_us(t));
+	kvblock_pool_(&c);
+
+	srand(seed); POOL_FILL(kvinline, &d, ptrs, length);
+	t = clock();
+	for(i = 0; i < length; i++) kvinline_pool_remove(&d, ptrs[i]);
+	fprintf(fp, "\t%f\n", diff_us(t));
+	kvinline_pool_(&d);
+
+	free(ptrs);
+}
+
+/* Churn: fills to `length` and then replaces a random item `length` times,
+ for the free-heap, the free-list, and the free-bitmap. */
+#define POOL_CHURN(pool, a, ptrs, length) do { \
+	size_t i_, j_; \
+	for(i_ = 0; i_ < (length); i_++) { \
+		(ptrs)[i_] = pool##_pool_new(a), assert((ptrs)[i_]); \
+		(ptrs)[i_]->key = (int)i_; \
+	} \
+	for(i_ = 0; i_ < (length); i_++) { \
+		j_ = (size_t)rand() / (RAND_MAX / (length) + 1); \
+		pool##_pool_remove(a, (ptrs)[j_]); \
+		(ptrs)[j_] = pool##_pool_new(a), assert((ptrs)[j_]); \
+		(ptrs)[j_]->key = (int)i_; \
+	} \
+} while(0)
+
+/** Random replacement in a pool of `length` with the free-heap, the
+ free-list, and the free-bitmap in slab zero; outputs the times to `fp`. */
+void free_list_timing(const size_t length, FILE *const fp) {
+	struct keyval_pool a = keyval_pool();
+	struct kvlist_pool b = kvlist_pool();
+	struct kvbitmap_pool c = kvbitmap_pool();
+	struct keyval **ptrs;
+	const unsigned seed = (unsigned)clock();
+	clock_t t;
+
+	if(!length || !(ptrs = malloc(sizeof *ptrs * length)))
+		{ perror("free list"); return; }
+
+	TIMING_CLEAR(keyval), srand(seed), t = clock();
+	POOL_CHURN(keyval, &a, ptrs, length);
+	fprintf(fp, "%lu\t%f", (unsigned long)length, diff_us(t));
+	TIMING_COUNTERS(keyval, length);
+	keyval_pool_(&a);
+
+	TIMING_CLEAR(kvlist), srand(seed), t = clock();
+	POOL_CHURN(kvlist, &b, ptrs, length);
+	fprintf(fp, "\t%f", diff_us(t));
+	TIMING_COUNTERS(kvlist, length);
+	kvlist_pool_(&b);
+
+	TIMING_CLEAR(kvbitmap), srand(seed), t = clock();
+	POOL_CHURN(kvbitmap, &c, ptrs, length);
+	fprintf(fp, "\t%f\n", diff_us(t));
+	TIMING_COUNTERS(kvbitmap, length);
+	kvbitmap_pool_(&c);
+
+	free(ptrs);
+}
+
+#undef POOL_CHURN
+
+/** @return A counter of data TLB misses in user space for this thread, or -1
+ if there are none, (not Linux, or in a virtual machine.) */
+static int tlb_open(void) {
+#ifdef __linux__
+	struct perf_event_attr attr;
+	memset(&attr, 0, sizeof attr);
+	attr.type = PERF_TYPE_HW_CACHE, attr.size = sizeof attr;
+	attr.config = PERF_COUNT_HW_CACHE_DTLB
+		| PERF_COUNT_HW_CACHE_OP_READ << 8
+		| PERF_COUNT_HW_CACHE_RESULT_MISS << 16;
+	attr.exclude_kernel = 1, attr.exclude_hv = 1;
+	return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+	return -1;
+#endif
+}
+
+/** @return The count of `tlb` from <fn:tlb_open>, or -1. */
+static double tlb_read(const int tlb) {
+#ifdef __linux__
+	perf_count count;
+	if(tlb >= 0 && read(tlb, &count, sizeof count) == sizeof count)
+		return (double)count;
+#else
+	(void)tlb;
+#endif
+	return -1.0;
+}
+
+/* Reads every item of `pool`, in the random order of `ptrs`, and then removes
+ them in that order; adds the time to `us`, and the TLB misses to `misses`. */
+#define POOL_WALK(pool, a, ptrs, length, us, misses) do { \
+	const int tlb_ = tlb_open(); \
+	double misses_; \
+	size_t i_; \
+	int sum_ = 0; \
+	clock_t t_; \
+	srand(seed); POOL_FILL(pool, a, ptrs, length); \
+	misses_ = tlb_read(tlb_), t_ = clock(); \
+	for(i_ = 0; i_ < (length); i_++) sum_ += (ptrs)[i_]->key; \
+	for(i_ = 0; i_ < (length); i_++) pool##_pool_remove(a, (ptrs)[i_]); \
+	(us) = diff_us(t_); \
+	(misses) = misses_ < 0 ? -1.0 : tlb_read(tlb_) - misses_; \
+	if(tlb_ >= 0) close(tlb_); \
+	pool##_pool_(a); \
+	if(sum_ == 42) fputc(' ', stderr); /* Not optimized away. */ \
+} while(0)
+
+/** Random access and removal of `length` items in a pool with slabs from
+ `malloc` and one with slabs in huge pages; outputs the times and data TLB
+ misses, if the counter is available, to `fp`. */
+void huge_timing(const size_t length, FILE *const fp) {
+	struct keyval_pool a = keyval_pool();
+	struct kvhuge_pool b = kvhuge_pool();
+	struct keyval **ptrs;
+	const unsigned seed = (unsigned)clock();
+	double us_a, us_b, misses_a, misses_b;
+
+	if(!length || !(ptrs = malloc(sizeof *ptrs * length)))
+		{ perror("huge"); return; }
+	POOL_WALK(keyval, &a, ptrs, length, us_a, misses_a);
+	POOL_WALK(kvhuge, &b, ptrs, length, us_b, misses_b);
+	fprintf(fp, "%lu\t%f\t%f\t%.0f\t%.0f\n", (unsigned long)length,
+		us_a, us_b, misses_a, misses_b);
+	free(ptrs);
+}
+
+#undef POOL_WALK
+
+#define COLOUR_ITEMS 8192 /* Big enough that `malloc` maps the slabs. */
+#define COLOUR_HOT 4 /* Items at the start of every slab that are read. */
+#define COLOUR_READS 50000000
+
+/* Puts one slab of `COLOUR_ITEMS` in each of `slabs` pools of type `pool`,
+ and reads the first `COLOUR_HOT` of each in turn, each read depending on the
+ one before, so the misses are not overlapped; adds the time to `us`. */
+#define POOL_ACROSS(pool, first, slabs, us) do { \
+	struct pool##_pool *a_; \
+	size_t i_, j_, r_; \
+	int next_ = 0; \
+	clock_t t_; \
+	if(!(a_ = malloc(sizeof *a_ * (slabs)))) { perror("colour"); break; } \
+	for(i_ = 0; i_ < (slabs); i_++) a_[i_] = pool##_pool(); \
+	for(i_ = 0; i_ < (slabs); i_++) { \
+		if(!((first)[i_] = pool##_pool_new_n(a_ + i_, COLOUR_ITEMS))) \
+			{ perror("colour"); break; } \
+		for(j_ = 0; j_ < COLOUR_HOT; j_++) \
+			(first)[i_][j_].key = (int)((j_ + 1) % COLOUR_HOT); \
+	} \
+	t_ = clock(); \
+	if(i_ == (slabs)) for(r_ = 0; r_ < COLOUR_READS; ) \
+		for(i_ = 0; i_ < (slabs); i_++, r_++) \
+		next_ = (first)[i_][next_].key; \
+	(us) = diff_us(t_); \
+	for(i_ = 0; i_ < (slabs); i_++) pool##_pool_(a_ + i_); \
+	free(a_); \
+	if(next_ == 42) fputc(' ', stderr); /* Not optimized away. */ \
+} while(0)
+
+/** Reads the same items of `slabs` slabs in as many pools, which all start
+ at the same offset from a page with slabs from `malloc`, and at different
+ offsets with coloured slabs; outputs the times to `fp`. */
+void colour_timing(const size_t slabs, FILE *const fp) {
+	struct keyval **first;
+	double us_a = 0, us_b = 0;
+
+	if(!slabs || !(first = malloc(sizeof *first * slabs)))
+		{ perror("colour"); return; }
+	POOL_ACROSS(keyval, first, slabs, us_a);
+	POOL_ACROSS(kvcolour, first, slabs, us_b);
+	fprintf(fp, "%lu\t%f\t%f\n", (unsigned long)slabs, us_a, us_b);
+	free(first);
+}
+
+#undef POOL_ACROSS
+#undef POOL_FILL
+
+#define CHURN_THREADS 64
+#define CHURN_OPS 1000000
+#define CHURN_LIVE 64
+
+/** Returns the wall time in microseconds; `clock` counts every thread. */
+static double wall_us(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return 1000000.0 * ts.tv_sec + ts.tv_nsec / 1000.0;
+}
+
+/* One thread of <fn:concurrent_timing>. */
+struct churn_thread {
+	pthread_mutex_t *lock;
+	struct keyval_pool *pool;
+	struct keyval_depot *depot;
+	struct keyval_percpu *percpu;
+	struct keyval_lockfree *lockfree;
+	unsigned seed;
+	int success;
+};
+
+/** Random allocation and removal of `CHURN_OPS` in a pool behind a mutex. */
+static void *mutex_churn(void *const arg) {
+	struct churn_thread *const t = arg;
+	struct keyval *live[CHURN_LIVE], *kv;
+	unsigned x = t->seed;
+	size_t i, j, n = 0;
+	for(i = 0; i < CHURN_OPS; i++) {
+		x ^= x << 13, x ^= x >> 17, x ^= x << 5;
+		if(n < CHURN_LIVE && (!n || x & 1)) {
+			pthread_mutex_lock(t->lock);
+			kv = keyval_pool_new(t->pool);
+			pthread_mutex_unlock(t->lock);
+			if(!kv) return 0;
+			kv->key = (int)i, live[n++] = kv;
+		} else {
+			j = (x >> 1) % n;
+			pthread_mutex_lock(t->lock);
+			keyval_pool_remove(t->pool, live[j]);
+			pthread_mutex_unlock(t->lock);
+			live[j] = live[--n];
+		}
+	}
+	pthread_mutex_lock(t->lock);
+	while(n) keyval_pool_remove(t->pool, live[--n]);
+	pthread_mutex_unlock(t->lock);
+	t->success = 1;
+	return 0;
+}
+
+/** The same as <fn:mutex_churn>, but through a cache on the depot. */
+static void *magazine_churn(void *const arg) {
+	struct churn_thread *const t = arg;
+	struct keyval_cache cache = keyval_cache(t->depot);
+	struct keyval *live[CHURN_LIVE], *kv;
+	unsigned x = t->seed;
+	size_t i, j, n = 0;
+	for(i = 0; i < CHURN_OPS; i++) {
+		x ^= x << 13, x ^= x >> 17, x ^= x << 5;
+		if(n < CHURN_LIVE && (!n || x & 1)) {
+			if(!(kv = keyval_cache_new(&cache))) goto finally;
+			kv->key = (int)i, live[n++] = kv;
+		} else {
+			j = (x >> 1) % n;
+			if(!keyval_cache_remove(&cache, live[j])) goto finally;
+			live[j] = live[--n];
+		}
+	}
+	while(n) if(!keyval_cache_remove(&cache, live[--n])) goto finally;
+	t->success = 1;
+finally:
+	keyval_cache_(&cache);
+	return 0;
+}
+
+/** The same as <fn:mutex_churn>, but through the shard of the CPU. */
+static void *percpu_churn(void *const arg) {
+	struct churn_thread *const t = arg;
+	struct keyval *live[CHURN_LIVE], *kv;
+	unsigned x = t->seed;
+	size_t i, j, n = 0;
+	for(i = 0; i < CHURN_OPS; i++) {
+		x ^= x << 13, x ^= x >> 17, x ^= x << 5;
+		if(n < CHURN_LIVE && (!n || x & 1)) {
+			if(!(kv = keyval_percpu_new(t->percpu))) return 0;
+			kv->key = (int)i, live[n++] = kv;
+		} else {
+			j = (x >> 1) % n;
+			if(!keyval_percpu_remove(t->percpu, live[j])) return 0;
+			live[j] = live[--n];
+		}
+	}
+	while(n) if(!keyval_percpu_remove(t->percpu, live[--n])) return 0;
+	t->success = 1;
+	return 0;
+}
+
+/** The same as <fn:mutex_churn>, but on a pool that the thread owns. Every
+ removal is from the owner thread, so this is the fast path. */
+static void *owner_churn(void *const arg) {
+	struct churn_thread *const t = arg;
+	struct keyval_owner owner;
+	struct keyval *live[CHURN_LIVE], *kv;
+	unsigned x = t->seed;
+	size_t i, j, n = 0;
+	keyval_owner(&owner);
+	for(i = 0; i < CHURN_OPS; i++) {
+		x ^= x << 13, x ^= x >> 17, x ^= x << 5;
+		if(n < CHURN_LIVE && (!n || x & 1)) {
+			if(!(kv = keyval_owner_new(&owner))) goto finally;
+			kv->key = (int)i, live[n++] = kv;
+		} else {
+			j = (x >> 1) % n;
+			if(!keyval_owner_remove(&owner, live[j])) goto finally;
+			live[j] = live[--n];
+		}
+	}
+	while(n) if(!keyval_owner_remove(&owner, live[--n])) goto finally;
+	t->success = 1;
+finally:
+	keyval_owner_(&owner);
+	return 0;
+}
+
+/** The same as <fn:mutex_churn>, but on one pool without a lock. */
+static void *lockfree_churn(void *const arg) {
+	struct churn_thread *const t = arg;
+	struct keyval *live[CHURN_LIVE], *kv;
+	unsigned x = t->seed;
+	size_t i, j, n = 0;
+	for(i = 0; i < CHURN_OPS; i++) {
+		x ^= x << 13, x ^= x >> 17, x ^= x << 5;
+		if(n < CHURN_LIVE && (!n || x & 1)) {
+			if(!(kv = keyval_lockfree_new(t->lockfree))) return 0;
+			kv->key = (int)i, live[n++] = kv;
+		} else {
+			j = (x >> 1) % n;
+			keyval_lockfree_remove(t->lockfree, live[j]);
+			live[j] = live[--n];
+		}
+	}
+	while(n) keyval_lockfree_remove(t->lockfree, live[--n]);
+	t->success = 1;
+	return 0;
+}
+
+/** Runs `run` on `threads` of `t` at once. @return Whether all succeeded. */
+static int churn(void *(*const run)(void *), struct churn_thread *const t,
+	const size_t threads) {
+	pthread_t id[CHURN_THREADS];
+	size_t i, created;
+	int success = 1;
+	assert(threads <= CHURN_THREADS);
+	for(created = 0; created < threads; created++)
+		if(pthread_create(id + created, 0, run, t + created))
+			{ success = 0; break; }
+	for(i = 0; i < created; i++)
+		if(pthread_join(id[i], 0) || !t[i].success) success = 0;
+	return success;
+}
+
+/** `threads` each do a fixed amount of random allocation and removal: on
+ one pool behind a mutex, on a depot with a cache per thread, on a shard per
+ CPU, on a pool owned by each thread, and on one lock-free pool; outputs the
+ wall times to `fp`. */
+void concurrent_timing(const size_t threads, FILE *const fp) {
+	struct churn_thread t[CHURN_THREADS];
+	pthread_mutex_t lock;
+	struct keyval_pool a = keyval_pool();
+	struct keyval_depot depot;
+	struct keyval_percpu percpu;
+	struct keyval_lockfree lockfree;
+	size_t i;
+	double then;
+
+	if(!threads || threads > CHURN_THREADS || pthread_mutex_init(&lock, 0))
+		{ perror("concurrent"); return; }
+	if(!keyval_depot(&depot))
+		{ perror("depot"); pthread_mutex_destroy(&lock); return; }
+	if(!keyval_percpu(&percpu, 0)) { perror("percpu");
+		keyval_depot_(&depot), pthread_mutex_destroy(&lock); return; }
+	keyval_lockfree(&lockfree);
+	for(i = 0; i < threads; i++) t[i].lock = &lock, t[i].pool = &a,
+		t[i].depot = &depot, t[i].percpu = &percpu, t[i].lockfree = &lockfree,
+		t[i].seed = 2463534242u + (unsigned)i;
+
+	for(i = 0; i < threads; i++) t[i].success = 0;
+	then = wall_us();
+	if(!churn(&mutex_churn, t, threads)) perror("mutex");
+	fprintf(fp, "%lu\t%f", (unsigned long)threads, wall_us() - then);
+
+	for(i = 0; i < threads; i++) t[i].success = 0;
+	then = wall_us();
+	if(!churn(&magazine_churn, t, threads)) perror("magazine");
+	fprintf(fp, "\t%f", wall_us() - then);
+
+	for(i = 0; i < threads; i++) t[i].success = 0;
+	then = wall_us();
+	if(!churn(&percpu_churn, t, threads)) perror("percpu");
+	fprintf(fp, "\t%f", wall_us() - then);
+
+	for(i = 0; i < threads; i++) t[i].success = 0;
+	then = wall_us();
+	if(!churn(&owner_churn, t, threads)) perror("owner");
+	fprintf(fp, "\t%f", wall_us() - then);
+
+	for(i = 0; i < threads; i++) t[i].success = 0;
+	then = wall_us();
+	if(!churn(&lockfree_churn, t, threads)) perror("lockfree");
+	fprintf(fp, "\t%f\n", wall_us() - then);
+
+	keyval_lockfree_(&lockfree);
+	keyval_depot_reap(&depot);
+	keyval_percpu_(&percpu);
+	keyval_depot_(&depot);
+	keyval_pool_(&a);
+	pthread_mutex_destroy(&lock);
+}
+
+#undef CHURN_THREADS
+#undef CHURN_OPS
+#undef CHURN_LIVE
+
+/** Replays `r` on the current pool, and outputs the time and the peak bytes,
+ from <fn:<P>pool_stats>, to `fp`. */
+void replay_pool(const struct replay *const r, FILE *const fp) {
+	struct keyval_pool a = keyval_pool();
+	struct keyval_pool_stats stats;
+	struct keyval **ptrs;
+	double us;
+	clock_t t;
+	if(!(ptrs = malloc(sizeof *ptrs * (r->lifetimes + 1))))
+		{ perror("replay"); return; }
+	t = clock();
+	REPLAY(keyval, &a, r, ptrs, (void)0);
+	us = diff_us(t);
+	keyval_pool_stats(&a, &stats);
+	fprintf(fp, "pool\t%f\t%lu\n", us,
+		(unsigned long)(sizeof a + stats.peak_bytes));
+	keyval_pool_(&a);
+	free(ptrs);
+}
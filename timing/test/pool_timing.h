@@ -0,0 +1,10 @@
+/* Timing of the current <src/pool.h>; it's in it's own translation unit
+ because it shares the `POOL_H` guard with <timing/src/deque_pool.h>. */
+
+#include <stdio.h>  /* FILE */
+#include <stddef.h> /* size_t */
+void teardown_timing(const size_t length, FILE *const fp);
+void free_list_timing(const size_t length, FILE *const fp);
+void huge_timing(const size_t length, FILE *const fp);
+void colour_timing(const size_t slabs, FILE *const fp);
+void concurrent_timing(const size_t threads, FILE *const fp);
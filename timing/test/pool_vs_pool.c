@@ -5,6 +5,8 @@
 #include <limits.h>	/* INT_MAX */
 #include <assert.h> /* assert */
 #include "orcish.h"
+#include "pool_timing.h"
+#include "replay.h"
 
 
 #define PARAM(A) A
@@ -108,6 +110,24 @@ static void keyval_value_to_string(const struct keyval *const kv,
 static double diff_us(clock_t then)
 	{ return 1000000.0 / CLOCKS_PER_SEC * (clock() - then); }
 
+/** @return The bytes that `a` has; secondary slots only count their items. */
+static size_t keyval_footprint(const struct keyval_pool *const a) {
+	size_t size = sizeof *a + a->slots.capacity * sizeof a->slots.data
+		+ a->free0.a.capacity * sizeof a->free0.a.data, i;
+	for(i = 0; i < a->slots.size; i++) size += sizeof a->slots.data[i]
+		+ a->slots.data[i]->size * sizeof(pool_keyval_type);
+	return size;
+}
+
+/** @return The bytes that `b` has. */
+static size_t oldkeyval_footprint(const struct oldkeyval_pool *const b) {
+	size_t size = sizeof *b;
+	const struct pool_oldkeyval_block *p;
+	for(p = b->largest; p; p = p->smaller)
+		size += sizeof *p + p->capacity * sizeof(struct pool_oldkeyval_node);
+	return size;
+}
+
 static void timing(const size_t length,
 	FILE *const fp_time, FILE *const fp_space) {
 	struct keyval_pool a = POOL_IDLE;
@@ -139,13 +159,8 @@ static void timing(const size_t length,
 		}
 	}
 	fprintf(fp_time, "%lu\t%f", length, diff_us(t));
-	{
-		size_t size = sizeof a + a.slots.capacity * sizeof a.slots.data
-			+ a.free0.a.capacity * sizeof a.free0.a.data;
-		for(i = 0; i < a.slots.size; i++) size += sizeof a.slots.data[i]
-			+ a.slots.data[i]->size * sizeof(pool_keyval_type);
-		fprintf(fp_space, "%lu\t%lu", length, (unsigned long)size);
-	}
+	fprintf(fp_space, "%lu\t%lu", length,
+		(unsigned long)keyval_footprint(&a));
 	keyval_pool_(&a);
 	keyvalref_array_clear(&c);
 	t = clock();
@@ -165,25 +180,87 @@ static void timing(const size_t length,
 		}
 	}
 	fprintf(fp_time, "\t%f\n", diff_us(t));
-	{
-		size_t size = sizeof b;
-		struct pool_oldkeyval_block *p;
-		for(p = b.largest; p; p = p->smaller)
-			size += sizeof *p + p->capacity * sizeof(struct pool_oldkeyval_node);
-		fprintf(fp_space, "\t%lu\n", (unsigned long)size);
-	}
+	fprintf(fp_space, "\t%lu\n", (unsigned long)oldkeyval_footprint(&b));
 	oldkeyval_pool_(&b);
 	keyvalref_array_(&c);
 }
 
-int main(void) {
+/** Replays `r` on the deque pool and the old pool; outputs the times, and
+ the peak bytes, measured after every new in a second pass, to `fp`. */
+static void replay_old(const struct replay *const r, FILE *const fp) {
+	struct keyval_pool a = POOL_IDLE;
+	struct oldkeyval_pool b = POOL_IDLE;
+	struct keyval **ptrs;
+	size_t peak, bytes;
+	double us;
+	clock_t t;
+	if(!(ptrs = malloc(sizeof *ptrs * (r->lifetimes + 1))))
+		{ perror("replay"); return; }
+	t = clock();
+	REPLAY(keyval, &a, r, ptrs, (void)0);
+	us = diff_us(t);
+	keyval_pool_(&a);
+	peak = 0;
+	REPLAY(keyval, &a, r, ptrs,
+		if((bytes = keyval_footprint(&a)) > peak) peak = bytes);
+	keyval_pool_(&a);
+	fprintf(fp, "deque\t%f\t%lu\n", us, (unsigned long)peak);
+	t = clock();
+	REPLAY(oldkeyval, &b, r, ptrs, (void)0);
+	us = diff_us(t);
+	oldkeyval_pool_(&b);
+	peak = 0;
+	REPLAY(oldkeyval, &b, r, ptrs,
+		if((bytes = oldkeyval_footprint(&b)) > peak) peak = bytes);
+	oldkeyval_pool_(&b);
+	fprintf(fp, "old\t%f\t%lu\n", us, (unsigned long)peak);
+	free(ptrs);
+}
+
+/** Replays the trace in `fn`, recorded with `POOL_TRACE`, on all the pools
+ and `malloc`. @return Success. */
+static int replay(const char *const fn) {
+	struct replay r;
+	FILE *fp;
+	int success;
+	if(!(fp = fopen(fn, "rb"))) { perror(fn); return 0; }
+	success = replay_read(&r, fp);
+	fclose(fp);
+	if(!success) { perror(fn); return 0; }
+	printf("Trace %s: %lu events, %lu lifetimes, %lu most live, over %f us.\n",
+		fn, (unsigned long)r.size, (unsigned long)r.lifetimes,
+		(unsigned long)r.peak, r.us);
+	if(r.item_size != sizeof(struct keyval))
+		printf("Items of %lu bytes are replayed with %lu.\n",
+		(unsigned long)r.item_size, (unsigned long)sizeof(struct keyval));
+	printf("# allocator\tus\tpeak bytes\n");
+	replay_pool(&r, stdout);
+	replay_old(&r, stdout);
+	replay_malloc(&r, stdout);
+	replay_(&r);
+	return 1;
+}
+
+/** With an argument, replays it as a trace; otherwise, the synthetic
+ timings. */
+int main(int argc, char **argv) {
 	unsigned seed = (unsigned)clock();
 	size_t length;
-	FILE *fp_time = 0, *fp_space = 0;
+	size_t threads;
+	FILE *fp_time = 0, *fp_space = 0, *fp_teardown = 0, *fp_free = 0,
+		*fp_huge = 0, *fp_colour = 0, *fp_concurrent = 0;
 	const char *const fn_time = "pool_vs_pool_time.data",
-		*const fn_space = "pool_vs_pool_space.data";
+		*const fn_space = "pool_vs_pool_space.data",
+		*const fn_teardown = "pool_teardown_time.data",
+		*const fn_free = "pool_free_list_time.data",
+		*const fn_huge = "pool_huge_time.data",
+		*const fn_colour = "pool_colour_time.data",
+		*const fn_concurrent = "pool_concurrent_time.data";
 	int success = EXIT_FAILURE;
 
+	if(argc == 2) return replay(argv[1]) ? EXIT_SUCCESS : EXIT_FAILURE;
+	if(argc > 2)
+		{ fprintf(stderr, "Usage: %s [trace]\n", argv[0]); return success; }
 	srand(seed), rand(), printf("Seed %u.\n", seed);
 	colour_pool_test();
 	oldcolour_pool_test();
@@ -199,6 +276,27 @@ int main(void) {
 	fprintf(fp_space, "# size\tnew\told\n");
 	for(length = 5; length < 100000000; length <<= 1)
 		timing(length, fp_time, fp_space);
+	if(!(fp_teardown = fopen(fn_teardown, "w"))) goto catch;
+	fprintf(fp_teardown, "# size\tsingle\tbatch\tradix\tblock\tinline\n");
+	for(length = 5; length < 10000000; length <<= 1)
+		teardown_timing(length, fp_teardown);
+	if(!(fp_free = fopen(fn_free, "w"))) goto catch;
+	fprintf(fp_free, "# size\theap\tlist\tbitmap\n");
+	for(length = 5; length < 10000000; length <<= 1)
+		free_list_timing(length, fp_free);
+	if(!(fp_huge = fopen(fn_huge, "w"))) goto catch;
+	fprintf(fp_huge, "# size\tmalloc\thuge\tmalloc dTLB\thuge dTLB\n");
+	for(length = 5; length < 10000000; length <<= 1)
+		huge_timing(length, fp_huge);
+	if(!(fp_colour = fopen(fn_colour, "w"))) goto catch;
+	fprintf(fp_colour, "# slabs\tmalloc\tcoloured\n");
+	for(length = 1; length <= 128; length <<= 1)
+		colour_timing(length, fp_colour);
+	if(!(fp_concurrent = fopen(fn_concurrent, "w"))) goto catch;
+	fprintf(fp_concurrent,
+		"# threads\tmutex\tmagazine\tpercpu\towner\tlockfree\n");
+	for(threads = 1; threads <= 64; threads <<= 1)
+		concurrent_timing(threads, fp_concurrent);
 	success = EXIT_SUCCESS;
 	goto finally;
 catch:
@@ -206,5 +304,10 @@ catch:
 finally:
 	if(fp_time) fclose(fp_time);
 	if(fp_space) fclose(fp_space);
+	if(fp_teardown) fclose(fp_teardown);
+	if(fp_free) fclose(fp_free);
+	if(fp_huge) fclose(fp_huge);
+	if(fp_colour) fclose(fp_colour);
+	if(fp_concurrent) fclose(fp_concurrent);
 	return success;
 }
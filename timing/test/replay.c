@@ -0,0 +1,129 @@
+/* Reads a trace of <src/trace.h> into lifetimes, and replays it with
+ `malloc`; the pools are replayed in the translation units that have them. */
+
+#define _POSIX_C_SOURCE 200112L /* clock_gettime */
+#include <stdlib.h> /* malloc free qsort */
+#include <stdio.h>  /* fprintf */
+#include <time.h>	/* clock */
+#include <errno.h>
+#include <assert.h> /* assert */
+#include "../../src/trace.h"
+#include "replay.h"
+
+struct keyval { int key; char value[12]; };
+
+/** Returns a time diffecence in microseconds from `then`. */
+static double diff_us(clock_t then)
+	{ return 1000000.0 / CLOCKS_PER_SEC * (clock() - then); }
+
+/* An item in the trace: the address, the event, and the clears before. */
+struct replay_address { pool_trace_address address; size_t event, clears; };
+
+/** Orders `a`, `b` by address, then event. @implements `qsort` */
+static int replay_address_order(const void *const a, const void *const b) {
+	const struct replay_address *const x = a, *const y = b;
+	if(x->address != y->address) return x->address < y->address ? -1 : 1;
+	return (x->event > y->event) - (x->event < y->event);
+}
+
+/** Reads a trace from `fp` into `r`. Each new is a lifetime; a remove
+ belongs to the new before it at the same address, unless there was a clear
+ between; removes of items from before the trace are dropped.
+ @return Success. @throws[EILSEQ, malloc, realloc] */
+int replay_read(struct replay *const r, FILE *const fp) {
+	struct pool_trace trace;
+	struct pool_trace_event e;
+	struct replay_address *address = 0, *x, *x_end, *live;
+	struct replay_event *event;
+	size_t capacity = 0, addresses = 0, clears = 0, size, n, i;
+	int success = 0;
+	assert(r && fp);
+	r->event = 0, r->size = r->lifetimes = r->peak = 0, r->us = 0.0;
+	if(!pool_trace_read(&trace, fp, &r->item_size)) return 0;
+	while(pool_trace_next(&trace, &e)) {
+		if(r->size >= capacity) {
+			capacity = capacity ? capacity * 2 : 4096;
+			if(!(event = realloc(r->event, sizeof *event * capacity))
+				|| (r->event = event, !(x = realloc(address,
+				sizeof *address * capacity)))) goto catch;
+			address = x;
+		}
+		r->us += e.ns / 1000.0;
+		event = r->event + r->size;
+		event->op = (enum replay_op)e.op;
+		if(e.op == POOL_TRACE_CLEAR)
+			{ event->id = r->lifetimes, clears++, r->size++; continue; }
+		if(e.op == POOL_TRACE_NEW) event->id = r->lifetimes++;
+		else event->id = (size_t)-1; /* Resolved after. */
+		x = address + addresses++;
+		x->address = e.address, x->event = r->size++, x->clears = clears;
+	}
+	if(trace.error) goto catch;
+	/* Match the removes with their news. */
+	qsort(address, addresses, sizeof *address, &replay_address_order);
+	for(x = address, x_end = x + addresses, live = 0; x < x_end; x++) {
+		event = r->event + x->event;
+		if(live && live->address != x->address) live = 0;
+		if(event->op == REPLAY_NEW) { live = x; continue; }
+		if(live && live->clears == x->clears)
+			event->id = r->event[live->event].id;
+		live = 0;
+	}
+	/* Drop what didn't match, and count the most live. */
+	for(i = 0, size = 0, n = 0; i < r->size; i++) {
+		event = r->event + i;
+		if(event->id == (size_t)-1) continue;
+		if(event->op == REPLAY_NEW) { if(++n > r->peak) r->peak = n; }
+		else if(event->op == REPLAY_REMOVE) n--;
+		else n = 0;
+		r->event[size++] = *event;
+	}
+	r->size = size;
+	success = 1;
+	goto finally;
+catch:
+	if(!errno) errno = EILSEQ;
+	replay_(r);
+finally:
+	free(address);
+	return success;
+}
+
+/** Frees `r`. */
+void replay_(struct replay *const r) {
+	if(!r) return;
+	free(r->event);
+	r->event = 0, r->size = r->lifetimes = r->peak = 0;
+}
+
+/** Replays `r` with `malloc`, and outputs the time and peak bytes to `fp`.
+ The bytes are estimated from the usual chunk: the item and a word of header,
+ rounded to two words, at least four. */
+void replay_malloc(const struct replay *const r, FILE *const fp) {
+	const size_t word = sizeof(size_t);
+	const struct replay_event *e, *const e_end = r->event + r->size;
+	struct keyval **ptrs;
+	size_t chunk = (sizeof **ptrs + word + 2 * word - 1) & ~(2 * word - 1),
+		first = 0, i;
+	double us;
+	clock_t t;
+	if(!(ptrs = calloc(r->lifetimes + 1, sizeof *ptrs)))
+		{ perror("replay"); return; }
+	t = clock();
+	for(e = r->event; e < e_end; e++) switch(e->op) {
+	case REPLAY_NEW:
+		ptrs[e->id] = malloc(sizeof **ptrs), assert(ptrs[e->id]);
+		ptrs[e->id]->key = (int)e->id;
+		break;
+	case REPLAY_REMOVE: free(ptrs[e->id]), ptrs[e->id] = 0; break;
+	case REPLAY_CLEAR:
+		for(i = first; i < e->id; i++) free(ptrs[i]), ptrs[i] = 0;
+		first = e->id;
+		break;
+	}
+	us = diff_us(t);
+	for(i = first; i < r->lifetimes; i++) free(ptrs[i]);
+	free(ptrs);
+	if(chunk < 4 * word) chunk = 4 * word;
+	fprintf(fp, "malloc\t%f\t%lu\n", us, (unsigned long)(r->peak * chunk));
+}
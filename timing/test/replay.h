@@ -0,0 +1,35 @@
+/* A trace of a pool from <src/trace.h>, read into lifetimes, for replaying
+ against the pools and `malloc`; <replay.c>. */
+
+#include <stdio.h>  /* FILE */
+#include <stddef.h> /* size_t */
+
+enum replay_op { REPLAY_NEW, REPLAY_REMOVE, REPLAY_CLEAR };
+/* `id` numbers the lifetimes in the order of new; a clear has the first id
+ that is not cleared. */
+struct replay_event { enum replay_op op; size_t id; };
+struct replay {
+	struct replay_event *event;
+	size_t size, lifetimes, peak, item_size; /* `peak` is the most live. */
+	double us; /* Recorded time from the first to the last event. */
+};
+
+int replay_read(struct replay *r, FILE *fp);
+void replay_(struct replay *r);
+void replay_malloc(const struct replay *r, FILE *fp);
+void replay_pool(const struct replay *r, FILE *fp);
+
+/* Replays `r` on `a`, a pool of type `pool`, with pointers to the lifetimes
+ in `ptrs`; `after_new` is evaluated after each new. */
+#define REPLAY(pool, a, r, ptrs, after_new) do { \
+	const struct replay_event *e_, *const end_ = (r)->event + (r)->size; \
+	for(e_ = (r)->event; e_ < end_; e_++) switch(e_->op) { \
+	case REPLAY_NEW: \
+		(ptrs)[e_->id] = pool##_pool_new(a), assert((ptrs)[e_->id]); \
+		(ptrs)[e_->id]->key = (int)e_->id; \
+		after_new; \
+		break; \
+	case REPLAY_REMOVE: pool##_pool_remove(a, (ptrs)[e_->id]); break; \
+	case REPLAY_CLEAR: pool##_pool_clear(a); break; \
+	} \
+} while(0)